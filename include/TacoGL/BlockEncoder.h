@@ -0,0 +1,130 @@
+#ifndef __TACOGL_BLOCK_ENCODER__
+#define __TACOGL_BLOCK_ENCODER__
+
+#include <vector>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Texture.h>
+#include <TacoGL/parallel.h>
+
+namespace TacoGL
+{
+
+  /**
+   * CPU encoder of RGBA8 images into BC1, BC3, BC4 or BC5 blocks.
+   *
+   * Rows of 4x4 blocks are split across a ThreadPool. The per block
+   * kernels (endpoint search, texel projections) use AVX2 or SSE2 when the
+   * library is compiled for them (__AVX2__, __SSE2__), plain C++
+   * otherwise. Partial blocks at the right and bottom edges repeat the
+   * last column and row.
+   */
+  class BlockEncoder
+  {
+  public:
+    enum class Format
+    {
+      BC1, ///< RGB, 1 bit alpha, 8 bytes per block.
+      BC3, ///< RGBA, 16 bytes per block.
+      BC4, ///< red channel, 8 bytes per block.
+      BC5  ///< red and green channels, 16 bytes per block.
+    };
+
+    /**
+     * Speed/quality trade-off of the color endpoint search (BC1 and BC3).
+     */
+    enum class Quality
+    {
+      FAST,   ///< bounding box diagonal.
+      NORMAL, ///< principal axis, inset extremes.
+      HIGH    ///< principal axis, then least squares refinement.
+    };
+
+    /**
+     * Retrieve the compressed internal format of an encoder format.
+     *
+     * @param format the block format.
+     * @param srgb true for sRGB color data (BC1 and BC3 only).
+     */
+    static gl::GLenum getInternalFormat(Format format, bool srgb = false);
+
+    /**
+     * Retrieve the size of a block, in bytes.
+     */
+    static size_t getBlockSize(Format format);
+
+    /**
+     * Compute the size of an encoded image, in bytes.
+     *
+     * @param format the block format.
+     * @param width the image width.
+     * @param height the image height.
+     */
+    static size_t getEncodedSize(Format format, size_t width, size_t height);
+
+    /**
+     * @param format the block format.
+     * @param quality the endpoint search quality.
+     * @param pool the threads to encode with, the global pool if null.
+     */
+    BlockEncoder(Format format, Quality quality = Quality::NORMAL, ThreadPool *pool = nullptr);
+    virtual ~BlockEncoder() = default;
+
+    Format getFormat() const { return m_format; }
+    Quality getQuality() const { return m_quality; }
+    void setQuality(Quality quality) { m_quality = quality; }
+
+    /**
+     * Encode an image.
+     *
+     * @param pixels the RGBA8 texels, rows from the first one.
+     * @param width the image width.
+     * @param height the image height.
+     * @param rowLength the number of texels between rows, 0 for width.
+     * @param blocks the destination, getEncodedSize() bytes.
+     */
+    void encode(
+      const unsigned char *pixels,
+      size_t width, size_t height,
+      size_t rowLength,
+      unsigned char *blocks
+    ) const;
+
+    /**
+     * Encode an image.
+     *
+     * @param pixels the RGBA8 texels, tightly packed.
+     * @param width the image width.
+     * @param height the image height.
+     * @return the blocks.
+     */
+    std::vector<unsigned char> encode(const unsigned char *pixels, size_t width, size_t height) const;
+
+    /**
+     * Encode an image and upload it as a texture level, with
+     * Texture::setCompressedData.
+     *
+     * @param texture the 2D texture, binded.
+     * @param level the texture level.
+     * @param pixels the RGBA8 texels, tightly packed.
+     * @param width the image width.
+     * @param height the image height.
+     * @param srgb true for sRGB color data.
+     */
+    void upload(
+      Texture &texture,
+      size_t level,
+      const unsigned char *pixels,
+      size_t width, size_t height,
+      bool srgb = false
+    ) const;
+
+  protected:
+    Format m_format;
+    Quality m_quality;
+    ThreadPool *m_pool;
+  };
+
+} // end namespace TacoGL
+
+#endif
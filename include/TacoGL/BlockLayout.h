@@ -0,0 +1,323 @@
+#ifndef __TACOGL_BLOCK_LAYOUT__
+#define __TACOGL_BLOCK_LAYOUT__
+
+#include <array>
+#include <tuple>
+#include <cstring>
+#include <type_traits>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/algebra.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Memory layouts of GLSL interface blocks.
+   */
+  enum class Layout
+  {
+    STD140, ///< uniform blocks.
+    STD430  ///< shader storage blocks.
+  };
+
+  namespace detail
+  {
+    constexpr size_t _roundUp(size_t value, size_t alignment)
+    {
+      return (value + alignment - 1) / alignment * alignment;
+    }
+
+    constexpr size_t _max(size_t a, size_t b)
+    {
+      return (a > b) ? a : b;
+    }
+
+    /**
+     * std140 rounds array and structure alignments up to a vec4.
+     */
+    constexpr size_t _blockAlignment(Layout layout, size_t alignment)
+    {
+      return (layout == Layout::STD140) ? _roundUp(alignment, 16) : alignment;
+    }
+  }
+
+  /**
+   * Alignment, size and storage of a C++ type in a GLSL block.
+   *
+   * Supported types are GLfloat, GLint, GLuint, GLdouble, Eigen column
+   * vectors and column-major matrices (algebra.h types), std::array of
+   * those and nested ShaderBlock.
+   *
+   * @tparam T the C++ type.
+   * @tparam LAYOUT the block layout.
+   */
+  template <typename T, Layout LAYOUT, typename Enable = void>
+  struct LayoutTraits;
+
+  template <typename T, Layout LAYOUT>
+  struct LayoutTraits<T, LAYOUT, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+  {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "GLSL scalars are 32 or 64 bits");
+
+    static constexpr size_t alignment = sizeof(T);
+    static constexpr size_t size = sizeof(T);
+
+    static void write(unsigned char *destination, const T &value)
+    {
+      std::memcpy(destination, &value, sizeof(T));
+    }
+
+    static void read(const unsigned char *source, T &value)
+    {
+      std::memcpy(&value, source, sizeof(T));
+    }
+  };
+
+  /**
+   * Vectors: vec2 aligns on 2 scalars, vec3 and vec4 on 4 scalars.
+   */
+  template <typename S, int ROWS, int OPTIONS, int MAX_ROWS, int MAX_COLUMNS, Layout LAYOUT>
+  struct LayoutTraits<Eigen::Matrix<S, ROWS, 1, OPTIONS, MAX_ROWS, MAX_COLUMNS>, LAYOUT>
+  {
+    static_assert(ROWS >= 2 && ROWS <= 4, "GLSL vectors have 2 to 4 components");
+
+    using Type = Eigen::Matrix<S, ROWS, 1, OPTIONS, MAX_ROWS, MAX_COLUMNS>;
+
+    static constexpr size_t alignment = ((ROWS == 2) ? 2 : 4) * LayoutTraits<S, LAYOUT>::size;
+    static constexpr size_t size = ROWS * LayoutTraits<S, LAYOUT>::size;
+
+    static void write(unsigned char *destination, const Type &value)
+    {
+      std::memcpy(destination, value.data(), size);
+    }
+
+    static void read(const unsigned char *source, Type &value)
+    {
+      std::memcpy(value.data(), source, size);
+    }
+  };
+
+  /**
+   * Matrices: stored as an array of column vectors.
+   */
+  template <typename S, int ROWS, int COLUMNS, int OPTIONS, int MAX_ROWS, int MAX_COLUMNS, Layout LAYOUT>
+  struct LayoutTraits<
+    Eigen::Matrix<S, ROWS, COLUMNS, OPTIONS, MAX_ROWS, MAX_COLUMNS>,
+    LAYOUT,
+    typename std::enable_if<(COLUMNS > 1)>::type
+  >
+  {
+    static_assert(COLUMNS <= 4, "GLSL matrices have 2 to 4 columns");
+    static_assert(!(OPTIONS & Eigen::RowMajor), "GLSL matrices are column-major");
+
+    using Type = Eigen::Matrix<S, ROWS, COLUMNS, OPTIONS, MAX_ROWS, MAX_COLUMNS>;
+    using Column = Eigen::Matrix<S, ROWS, 1>;
+
+    static constexpr size_t stride = detail::_blockAlignment(LAYOUT, LayoutTraits<Column, LAYOUT>::alignment);
+    static constexpr size_t alignment = stride;
+    static constexpr size_t size = COLUMNS * stride;
+
+    static void write(unsigned char *destination, const Type &value)
+    {
+      for (int column = 0; column < COLUMNS; ++column)
+      {
+        std::memcpy(destination + column * stride, value.data() + column * ROWS, ROWS * sizeof(S));
+      }
+    }
+
+    static void read(const unsigned char *source, Type &value)
+    {
+      for (int column = 0; column < COLUMNS; ++column)
+      {
+        std::memcpy(value.data() + column * ROWS, source + column * stride, ROWS * sizeof(S));
+      }
+    }
+  };
+
+  /**
+   * Arrays: the element stride is rounded up to the element alignment.
+   */
+  template <typename T, size_t COUNT, Layout LAYOUT>
+  struct LayoutTraits<std::array<T, COUNT>, LAYOUT>
+  {
+    using Type = std::array<T, COUNT>;
+
+    static constexpr size_t alignment = detail::_blockAlignment(LAYOUT, LayoutTraits<T, LAYOUT>::alignment);
+    static constexpr size_t stride = detail::_roundUp(LayoutTraits<T, LAYOUT>::size, alignment);
+    static constexpr size_t size = COUNT * stride;
+
+    static void write(unsigned char *destination, const Type &value)
+    {
+      for (size_t i = 0; i < COUNT; ++i)
+      {
+        LayoutTraits<T, LAYOUT>::write(destination + i * stride, value[i]);
+      }
+    }
+
+    static void read(const unsigned char *source, Type &value)
+    {
+      for (size_t i = 0; i < COUNT; ++i)
+      {
+        LayoutTraits<T, LAYOUT>::read(source + i * stride, value[i]);
+      }
+    }
+  };
+
+  namespace detail
+  {
+    template <Layout LAYOUT, size_t INDEX, typename... Members>
+    struct _memberOffset;
+
+    template <Layout LAYOUT, typename... Members>
+    struct _memberOffset<LAYOUT, 0, Members...>
+    {
+      static constexpr size_t value = 0;
+    };
+
+    template <Layout LAYOUT, size_t INDEX, typename... Members>
+    struct _memberOffset
+    {
+      using Previous = LayoutTraits<typename std::tuple_element<INDEX - 1, std::tuple<Members...>>::type, LAYOUT>;
+      using Current = LayoutTraits<typename std::tuple_element<INDEX, std::tuple<Members...>>::type, LAYOUT>;
+
+      static constexpr size_t value = _roundUp(
+        _memberOffset<LAYOUT, INDEX - 1, Members...>::value + Previous::size,
+        Current::alignment
+      );
+    };
+
+    template <Layout LAYOUT, typename... Members>
+    struct _maxAlignment;
+
+    template <Layout LAYOUT>
+    struct _maxAlignment<LAYOUT>
+    {
+      static constexpr size_t value = 4;
+    };
+
+    template <Layout LAYOUT, typename First, typename... Others>
+    struct _maxAlignment<LAYOUT, First, Others...>
+    {
+      static constexpr size_t value = _max(
+        LayoutTraits<First, LAYOUT>::alignment,
+        _maxAlignment<LAYOUT, Others...>::value
+      );
+    };
+  }
+
+  /**
+   * Client side image of a GLSL interface block, laid out at compile time.
+   *
+   * Members are declared in the GLSL order and accessed by index, their
+   * offsets are compile-time constants that can be checked against the
+   * shader:
+   *
+   *   // layout(std140) uniform Light { vec3 position; float radius; mat4 shadow; };
+   *   using Light = Std140Block<Vector3, GLfloat, Matrix4>;
+   *   static_assert(Light::offset<2>() == 16, "Light layout mismatch");
+   *
+   *   Light light;
+   *   light.set<0>(position);
+   *   buffer.set(light, 0);
+   *
+   * The whole block is then uploaded by a single buffer write.
+   *
+   * @tparam LAYOUT the block layout.
+   * @tparam Members the member types.
+   */
+  template <Layout LAYOUT, typename... Members>
+  class ShaderBlock
+  {
+  public:
+    static_assert(sizeof...(Members) > 0, "Blocks have at least one member");
+
+    template <size_t INDEX>
+    using Member = typename std::tuple_element<INDEX, std::tuple<Members...>>::type;
+
+    static constexpr size_t MEMBER_COUNT = sizeof...(Members);
+
+    /**
+     * The block alignment when nested or in an array.
+     */
+    static constexpr size_t ALIGNMENT = detail::_blockAlignment(LAYOUT, detail::_maxAlignment<LAYOUT, Members...>::value);
+
+    /**
+     * The block size, padded to its alignment.
+     */
+    static constexpr size_t SIZE = detail::_roundUp(
+      detail::_memberOffset<LAYOUT, MEMBER_COUNT - 1, Members...>::value +
+        LayoutTraits<Member<MEMBER_COUNT - 1>, LAYOUT>::size,
+      ALIGNMENT
+    );
+
+    /**
+     * Retrieve the offset of a member from block start, in bytes.
+     */
+    template <size_t INDEX>
+    static constexpr size_t offset()
+    {
+      return detail::_memberOffset<LAYOUT, INDEX, Members...>::value;
+    }
+
+    ShaderBlock()
+    {
+      m_data.fill(0);
+    }
+
+    const unsigned char* data() const { return m_data.data(); }
+    unsigned char* data() { return m_data.data(); }
+    constexpr size_t size() const { return SIZE; }
+
+    template <size_t INDEX>
+    void set(const Member<INDEX> &value)
+    {
+      LayoutTraits<Member<INDEX>, LAYOUT>::write(m_data.data() + offset<INDEX>(), value);
+    }
+
+    template <size_t INDEX>
+    Member<INDEX> get() const
+    {
+      Member<INDEX> value;
+      LayoutTraits<Member<INDEX>, LAYOUT>::read(m_data.data() + offset<INDEX>(), value);
+      return value;
+    }
+
+  protected:
+    std::array<unsigned char, SIZE> m_data;
+  };
+
+  template <Layout LAYOUT, typename... Members>
+  constexpr size_t ShaderBlock<LAYOUT, Members...>::SIZE;
+
+  /**
+   * Nested blocks.
+   */
+  template <typename... Members, Layout LAYOUT>
+  struct LayoutTraits<ShaderBlock<LAYOUT, Members...>, LAYOUT>
+  {
+    using Type = ShaderBlock<LAYOUT, Members...>;
+
+    static constexpr size_t alignment = Type::ALIGNMENT;
+    static constexpr size_t size = Type::SIZE;
+
+    static void write(unsigned char *destination, const Type &value)
+    {
+      std::memcpy(destination, value.data(), size);
+    }
+
+    static void read(const unsigned char *source, Type &value)
+    {
+      std::memcpy(value.data(), source, size);
+    }
+  };
+
+  template <typename... Members>
+  using Std140Block = ShaderBlock<Layout::STD140, Members...>;
+
+  template <typename... Members>
+  using Std430Block = ShaderBlock<Layout::STD430, Members...>;
+
+} // end namespace TacoGL
+
+#endif
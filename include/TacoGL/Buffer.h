@@ -1,15 +1,18 @@
 #ifndef __TACOGL_BUFFER__
 #define __TACOGL_BUFFER__
 
+#include <cassert>
 #include <vector>
-#include <unordered_map>
-#include <unordered_set>
+#include <array>
+#include <utility>
 #include <iterator>
 #include <algorithm>
+#include <type_traits>
 
 #include <TacoGL/OpenGL.h>
 #include <TacoGL/Error.h>
 #include <TacoGL/get.h>
+#include <TacoGL/format.h>
 #include <TacoGL/Object.h>
 
 namespace TacoGL
@@ -17,35 +20,82 @@ namespace TacoGL
 
   /**
    * Manages buffer bindings.
+   *
+   * Bindings are kept in a flat table indexed by target slot, which also
+   * records the buffer currently binded to each target so redundant
+   * glBindBuffer calls are skipped.
    */
   class BufferManager
   {
   public:
-    using BindedTargetMap = std::unordered_set<gl::GLenum>;
-    using BindingMap = std::unordered_map<gl::GLuint, gl::GLenum>;
+    static const size_t TARGET_COUNT = 12; ///< the number of buffer targets.
+    static const size_t INVALID_SLOT = TARGET_COUNT;
+
+    using BindingTable = std::array<gl::GLuint, TARGET_COUNT>;
+
+    /**
+     * Retrieve the table slot of a buffer target.
+     * @param target the buffer target.
+     * @return the slot, INVALID_SLOT for unknown targets.
+     */
+    static size_t getSlot(gl::GLenum target);
+
+    /**
+     * Retrieve the buffer target of a table slot.
+     * @param slot the slot, lower than TARGET_COUNT.
+     */
+    static gl::GLenum getSlotTarget(size_t slot);
 
     BufferManager();
 
     virtual ~BufferManager();
 
-    const BindedTargetMap & getTarget() const;
-    const BindingMap & getBinding() const;
+    const BindingTable & getBinding() const { return m_binding; }
     bool isAvaible(gl::GLenum target) const;
     bool isBinded(gl::GLuint bufferId) const;
-    bool isBinded(gl::GLuint bufferId, gl::GLenum target) const;
+    bool isBinded(gl::GLuint bufferId, size_t slot) const { return m_binding[slot] == bufferId; }
     gl::GLenum getBinding(gl::GLuint bufferId) const;
+    gl::GLuint getBuffer(size_t slot) const { return m_binding[slot]; }
 
+    /**
+     * Bind a buffer, does nothing if it is already binded to the target.
+     * @param target the target to bind the buffer to.
+     * @param bufferId the buffer to bind.
+     */
     void bind(gl::GLenum target, gl::GLuint bufferId);
 
     void unbind(gl::GLuint bufferId);
+
+    /**
+     * Record a binding made outside of the manager, for instance by
+     * glBindBufferBase. Does not call OpenGL.
+     * @param target the target binded to.
+     * @param bufferId the binded buffer.
+     */
+    void record(gl::GLenum target, gl::GLuint bufferId);
+
+    /**
+     * Forget the binding of a target, for instance when it has been
+     * changed outside of the manager. Does not call OpenGL.
+     * @param target the target to reset.
+     */
+    void reset(gl::GLenum target);
+
+    /**
+     * Forget all the bindings of a buffer, when it is deleted.
+     * @param bufferId the deleted buffer.
+     */
+    void release(gl::GLuint bufferId);
     
     void debug() const;
 
   protected:
-    BindedTargetMap m_target;
-    BindingMap m_binding;
+    BindingTable m_binding; ///< binded buffer per target slot, 0 if none.
   };
 
+  template <typename T>
+  class MappedRange;
+
   /**
    * This class is designed to use GPU memory OpenGL buffers.
    */
@@ -55,16 +105,101 @@ namespace TacoGL
     template <gl::GLenum TARGET>
     static gl::GLuint getBinding();
 
+    /**
+     * Check if the context supports Direct State Access on buffers
+     * (OpenGL 4.5 or ARB_direct_state_access).
+     */
+    static bool hasDirectStateAccess();
+
+    /**
+     * Check if buffers are updated with Direct State Access, without
+     * binding. Enabled by default when supported.
+     */
+    static bool isDirectStateAccessEnabled();
+
+    /**
+     * Select the buffer update path. Buffers should be created after the
+     * selection, ids generated in binding mode are not usable by Direct
+     * State Access until they have been binded once.
+     *
+     * @param enabled true to use Direct State Access, when supported.
+     */
+    static void setDirectStateAccess(bool enabled);
+
+    /**
+     * Check if buffers can be filled by glClearBufferSubData (OpenGL 4.3
+     * or ARB_clear_buffer_object).
+     */
+    static bool hasClearBuffer();
+
+    /**
+     * Check if buffer contents can be invalidated (OpenGL 4.3 or
+     * ARB_invalidate_subdata).
+     */
+    static bool hasInvalidate();
+
+    /**
+     * Check if buffers can be filled by a compute shader (OpenGL 4.3 or
+     * ARB_compute_shader with ARB_shader_storage_buffer_object).
+     */
+    static bool hasComputeFill();
+
+    /**
+     * Delete the compute fill program of the current context, built by
+     * the first fillData of each context. To call while the context is
+     * current, before destroying it; otherwise the program goes with the
+     * context.
+     */
+    static void releaseFillProgram();
+
     Buffer();
     virtual ~Buffer();
 
     size_t getSize() const;
 
+    /**
+     * Check if the storage has been allocated with glBufferStorage.
+     */
+    bool isImmutable() const { return m_immutable; }
+
+    /**
+     * Check if full overwrites orphan the storage.
+     */
+    bool isOrphaning() const { return m_orphaning; }
+
+    /**
+     * Make full overwrites (set with offset 0 and the whole size) orphan
+     * the storage instead of waiting for pending draws reading it.
+     * Mutable storage is re-specified with the same usage, immutable
+     * storage is invalidated. Disabled by default.
+     *
+     * @param enabled true to orphan on full overwrites.
+     */
+    void setOrphaning(bool enabled) { m_orphaning = enabled; }
+
     bool isBinded() const;
     gl::GLenum getTarget() const;
 
     /**
-     * Binds the buffer in the current OpenGl context.
+     * Forget the binding of a target changed outside of TacoGL, so the
+     * next bind is not skipped.
+     *
+     * @param target the target to reset.
+     */
+    static void resetBinding(gl::GLenum target);
+
+    /**
+     * Record a binding made outside of Buffer, for instance by
+     * glBindBufferRange which also binds the generic binding point.
+     *
+     * @param target the target binded to.
+     * @param bufferId the binded buffer.
+     */
+    static void recordBinding(gl::GLenum target, gl::GLuint bufferId);
+
+    /**
+     * Binds the buffer in the current OpenGl context. Not needed to
+     * update the buffer when Direct State Access is enabled.
      *
      * @param target the target to bind the buffer to.
      * @see glBindBuffer
@@ -76,6 +211,27 @@ namespace TacoGL
      */
     void unbind();
 
+    /**
+     * Binds the whole buffer to an indexed binding point.
+     *
+     * @param target GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER,
+     *               GL_ATOMIC_COUNTER_BUFFER or GL_TRANSFORM_FEEDBACK_BUFFER.
+     * @param index the binding point index.
+     * @see glBindBufferBase
+     */
+    void bindBase(gl::GLenum target, size_t index);
+
+    /**
+     * Binds a range of the buffer to an indexed binding point.
+     *
+     * @param target the indexed target.
+     * @param index the binding point index.
+     * @param offset the offset from buffer start, in bytes.
+     * @param size the range size, in bytes.
+     * @see glBindBufferRange
+     */
+    void bindRange(gl::GLenum target, size_t index, size_t offset, size_t size);
+
     /**
      * Allocate mutable storage in GPU memory.
      * 
@@ -100,9 +256,172 @@ namespace TacoGL
     void allocate(size_t size, gl::MapBufferUsageMask flags, const T* data = nullptr);
 
 
+    /**
+     * Allocate raw mutable storage in GPU memory.
+     *
+     * @param size the number of bytes to allocate.
+     * @param usage OpenGL memory usage.
+     * @param data the memory to initialize from, may be nullptr.
+     * @see glBufferData
+     */
+    void allocateData(size_t size, gl::GLenum usage, const void *data = nullptr);
+
+    /**
+     * Allocate raw immutable storage in GPU memory.
+     *
+     * @param size the number of bytes to allocate.
+     * @param flags OpenGL flags for persistent storage.
+     * @param data the memory to initialize from, may be nullptr.
+     * @see glBufferStorage
+     */
+    void allocateData(size_t size, gl::MapBufferUsageMask flags, const void *data = nullptr);
+
+    /**
+     * Update raw data in GPU memory.
+     *
+     * @param offset the offset from buffer start, in bytes.
+     * @param size the number of bytes to set.
+     * @param data the memory to read from.
+     * @see glBufferSubData
+     */
+    void setData(size_t offset, size_t size, const void *data);
+
+    /**
+     * Retrieve raw data from GPU memory.
+     *
+     * @param offset the offset from buffer start, in bytes.
+     * @param size the number of bytes to get.
+     * @param data the memory to write into.
+     * @see glGetBufferSubData
+     */
+    void getData(size_t offset, size_t size, void *data) const;
+
+    /**
+     * Copy raw data from another buffer, GPU side.
+     *
+     * @param source the buffer to read from.
+     * @param readOffset the offset from source start, in bytes.
+     * @param writeOffset the offset from buffer start, in bytes.
+     * @param size the number of bytes to copy.
+     * @see glCopyBufferSubData
+     */
+    void copy(const Buffer &source, size_t readOffset, size_t writeOffset, size_t size);
+
+    /**
+     * Invalidate the content of the buffer, letting the driver hand out
+     * fresh memory instead of synchronizing with pending reads. No-op
+     * without hasInvalidate().
+     *
+     * @see glInvalidateBufferData
+     */
+    void invalidate();
+
+    /**
+     * Invalidate a range of the buffer. No-op without hasInvalidate().
+     *
+     * @param offset the offset from buffer start, in bytes.
+     * @param size the number of bytes to invalidate.
+     * @see glInvalidateBufferSubData
+     */
+    void invalidateRange(size_t offset, size_t size);
+
+    /**
+     * Fill a raw range with a repeated value, GPU side.
+     *
+     * @param internalFormat the sized format of the value.
+     * @param format the components of the value.
+     * @param type the components datatype.
+     * @param offset the offset from buffer start, in bytes.
+     * @param size the number of bytes to fill, a multiple of the value size.
+     * @param data the value, nullptr to fill with zeros.
+     * @see glClearBufferSubData
+     */
+    void clearData(
+      gl::GLenum internalFormat,
+      gl::GLenum format,
+      gl::GLenum type,
+      size_t offset,
+      size_t size,
+      const void *data
+    );
+
+    /**
+     * Fill a raw range with a repeated pattern, without glClearBufferSubData.
+     *
+     * Patterns of 4, 8, 12 or 16 bytes at a 4 bytes aligned offset are
+     * written by a compute shader, when supported. Otherwise the range is
+     * uploaded by chunks from a small staging block. The compute path
+     * restores the program in use and the shader storage binding 0, and
+     * ends with a barrier over the buffer sourced operations.
+     *
+     * @param offset the offset from buffer start, in bytes.
+     * @param size the number of bytes to fill, a multiple of patternSize.
+     * @param pattern the bytes to repeat.
+     * @param patternSize the number of bytes to repeat.
+     * @see glDispatchCompute
+     */
+    void fillData(size_t offset, size_t size, const void *pattern, size_t patternSize);
+
+    /**
+     * Fill a range with a value, GPU side, without client side array.
+     *
+     * @tparam T the value type, with a ClientFormat.
+     * @param value the value to repeat.
+     * @param offset the offset from buffer start, in elements.
+     * @param count the number of elements to fill.
+     * @see glClearBufferSubData
+     */
+    template <typename T>
+    void fill(const T &value, size_t offset, size_t count);
+
+    /**
+     * Map a raw range of GPU memory in client memory.
+     *
+     * @param offset the offset from buffer start, in bytes.
+     * @param size the number of bytes to map.
+     * @param access OpenGL access flags.
+     * @return a pointer to the mapped memory.
+     * @see glMapBufferRange
+     */
+    void* mapData(size_t offset, size_t size, gl::BufferAccessMask access);
+
+    /**
+     * Flush writes to a range mapped with MAP_FLUSH_EXPLICIT.
+     *
+     * @param offset the offset from the mapped range start, in bytes.
+     * @param size the number of bytes to flush.
+     * @see glFlushMappedBufferRange
+     */
+    void flushData(size_t offset, size_t size);
+
+    /**
+     * Unmap the buffer.
+     *
+     * @return false if the content has been corrupted while mapped.
+     * @see glUnmapBuffer
+     */
+    bool unmap();
+
+    /**
+     * Map a range of GPU memory in client memory.
+     *
+     * @tparam T datatype to map.
+     * @param offset the offset from buffer start, in elements.
+     * @param count the number of elements to map.
+     * @param access OpenGL access flags (MAP_INVALIDATE_RANGE,
+     *               MAP_UNSYNCHRONIZED, MAP_FLUSH_EXPLICIT...).
+     * @return a mapped range, unmapped when destroyed.
+     * @see glMapBufferRange
+     */
+    template <typename T>
+    MappedRange<T> map(size_t offset, size_t count, gl::BufferAccessMask access);
+
     /**
      * Update data in GPU memory.
      * 
+     * Pointers and std::vector iterators are read in place, other
+     * iterators are copied into a temporary array first.
+     *
      * @param first an iterator to read from.
      * @see glBufferSubData
      */
@@ -120,10 +439,24 @@ namespace TacoGL
     template <typename InputIterator>
     void set(const InputIterator first, size_t count, size_t offset);
 
+    /**
+     * Update data in GPU memory from a contiguous range, without copy.
+     *
+     * @param range any container exposing data() and size() over
+     *              contiguous memory (std::vector, std::array, Eigen::Map...).
+     * @param offset the offset from buffer start, in elements.
+     * @see glBufferSubData
+     */
+    template <typename ContiguousRange>
+    void set(const ContiguousRange &range, size_t offset);
+
 
     /**
      * Retrieve data from GPU memory.
      * 
+     * Pointers and std::vector iterators are written in place, other
+     * iterators are filled from a temporary array.
+     *
      * @param first an iterator to write into.
      * @see glGetBufferSubData
      */
@@ -141,10 +474,103 @@ namespace TacoGL
     template <typename OutputIterator>
     void get(OutputIterator first, size_t count, size_t offset) const;
 
+    /**
+     * Retrieve data from GPU memory into a contiguous range, without copy.
+     *
+     * @param range any container exposing data() and size() over
+     *              contiguous memory (std::vector, std::array, Eigen::Map...).
+     * @param offset the offset from buffer start, in elements.
+     * @see glGetBufferSubData
+     */
+    template <typename ContiguousRange>
+    void get(ContiguousRange &range, size_t offset) const;
+
   protected:
+    enum class DirectStateAccess
+    {
+      UNKNOWN,
+      ENABLED,
+      DISABLED
+    };
+
     static BufferManager s_manager; ///< buffer bindings manager.
+    static DirectStateAccess s_directStateAccess; ///< buffer update path.
 
     size_t m_size; ///< the buffer size in memory.
+    gl::GLenum m_usage; ///< the mutable storage usage.
+    bool m_immutable; ///< if the storage is immutable.
+    bool m_orphaning; ///< if full overwrites orphan the storage.
+    size_t m_slot; ///< the binding slot, BufferManager::INVALID_SLOT if none.
+  };
+
+  /**
+   * RAII view over a mapped buffer range, unmapped when destroyed.
+   *
+   * With MAP_FLUSH_EXPLICIT, ranges passed to flush(first, count) are
+   * merged and sent to OpenGL in one pass by flush() or on unmap.
+   * In binding mode, the buffer must stay binded while mapped.
+   */
+  template <typename T>
+  class MappedRange
+  {
+  public:
+    using FlushRange = std::pair<size_t, size_t>;
+
+    /**
+     * Map a range.
+     *
+     * @param buffer the buffer to map.
+     * @param offset the offset from buffer start, in elements.
+     * @param count the number of elements to map.
+     * @param access OpenGL access flags.
+     */
+    MappedRange(Buffer &buffer, size_t offset, size_t count, gl::BufferAccessMask access);
+    MappedRange(const MappedRange &other) = delete;
+    MappedRange(MappedRange &&other);
+    virtual ~MappedRange();
+
+    MappedRange & operator=(const MappedRange &other) = delete;
+
+    bool isMapped() const { return m_data != nullptr; }
+    size_t getOffset() const { return m_offset; }
+    size_t size() const { return m_count; }
+
+    T* data() { return m_data; }
+    const T* data() const { return m_data; }
+    T* begin() { return m_data; }
+    T* end() { return m_data + m_count; }
+
+    T& operator[](size_t index) { return m_data[index]; }
+    const T& operator[](size_t index) const { return m_data[index]; }
+
+    /**
+     * Mark elements as written, to be flushed by flush().
+     *
+     * @param first the first element, from range start.
+     * @param count the number of elements.
+     */
+    void flush(size_t first, size_t count);
+
+    /**
+     * Flush the marked elements, merging contiguous ranges.
+     *
+     * @see glFlushMappedBufferRange
+     */
+    void flush();
+
+    /**
+     * Flush and unmap the range.
+     *
+     * @return false if the content has been corrupted while mapped.
+     */
+    bool unmap();
+
+  protected:
+    Buffer *m_buffer;
+    T *m_data;
+    size_t m_offset;
+    size_t m_count;
+    std::vector<FlushRange> m_flushRanges; ///< pending (first, count) ranges.
   };
 
   #include <TacoGL/Buffer.hpp>
@@ -1,119 +1,261 @@
 // Others
 
-template <typename T>
-void Buffer::allocate(size_t size, gl::GLenum usage, const T* data)
+namespace detail
 {
-  assert(isBinded());
+  /**
+   * Tells if an iterator walks contiguous memory, in which case the
+   * elements can be handed to OpenGL without a staging copy.
+   */
+  template <
+    typename Iterator,
+    typename T = typename std::iterator_traits<Iterator>::value_type
+  >
+  struct _isContiguous : std::integral_constant<
+    bool,
+    std::is_pointer<Iterator>::value || (
+      !std::is_same<T, bool>::value && (
+        std::is_same<Iterator, typename std::vector<T>::iterator>::value ||
+        std::is_same<Iterator, typename std::vector<T>::const_iterator>::value
+      )
+    )
+  >
+  {
+
+  };
+
+  template <typename InputIterator>
+  inline void _set(
+    Buffer &buffer,
+    InputIterator first,
+    size_t count,
+    size_t offset,
+    std::true_type
+  )
+  {
+    using value_t = typename std::iterator_traits<InputIterator>::value_type;
+
+    buffer.setData(
+      offset * sizeof(value_t),
+      count * sizeof(value_t),
+      static_cast<const void*>(std::addressof(*first))
+    );
+  }
+
+  template <typename InputIterator>
+  inline void _set(
+    Buffer &buffer,
+    InputIterator first,
+    size_t count,
+    size_t offset,
+    std::false_type
+  )
+  {
+    using value_t = typename std::iterator_traits<InputIterator>::value_type;
+
+    std::vector<value_t> array(count);
+
+    std::copy_n(first, count, array.begin());
+
+    _set(buffer, array.data(), count, offset, std::true_type());
+  }
 
-  gl::GLenum target = getTarget();
-  m_size = size * sizeof(T);
+  template <typename OutputIterator>
+  inline void _get(
+    const Buffer &buffer,
+    OutputIterator first,
+    size_t count,
+    size_t offset,
+    std::true_type
+  )
+  {
+    using value_t = typename std::iterator_traits<OutputIterator>::value_type;
 
-  gl::glBufferData(
-    target,
-    m_size,
-    static_cast<const void*>(data),
-    usage
-  );
+    buffer.getData(
+      offset * sizeof(value_t),
+      count * sizeof(value_t),
+      static_cast<void*>(std::addressof(*first))
+    );
+  }
+
+  template <typename OutputIterator>
+  inline void _get(
+    const Buffer &buffer,
+    OutputIterator first,
+    size_t count,
+    size_t offset,
+    std::false_type
+  )
+  {
+    using value_t = typename std::iterator_traits<OutputIterator>::value_type;
+
+    std::vector<value_t> array(count);
+
+    _get(buffer, array.data(), count, offset, std::true_type());
+
+    std::copy_n(array.begin(), count, first);
+  }
+}
+
+
+template <typename T>
+void Buffer::allocate(size_t size, gl::GLenum usage, const T* data)
+{
+  allocateData(size * sizeof(T), usage, static_cast<const void*>(data));
 }
 
 template <typename T>
 void Buffer::allocate(size_t size, gl::MapBufferUsageMask flags, const T* data)
 {
-  assert(isBinded());
+  allocateData(size * sizeof(T), flags, static_cast<const void*>(data));
+}
 
-  gl::GLenum target = getTarget();
-  m_size = size * sizeof(T);
+template <typename T>
+MappedRange<T> Buffer::map(size_t offset, size_t count, gl::BufferAccessMask access)
+{
+  return MappedRange<T>(*this, offset, count, access);
+}
 
-  gl::glBufferStorage(
-    target,
-    m_size,
-    static_cast<const void*>(data),
-    flags
-  );
+template <typename T>
+void Buffer::fill(const T &value, size_t offset, size_t count)
+{
+  using Format = ClientFormat<T>;
+
+  if (hasClearBuffer())
+  {
+    clearData(
+      Format::internalFormat,
+      Format::format,
+      Format::type,
+      offset * sizeof(T),
+      count * sizeof(T),
+      &value
+    );
+  }
+  else
+  {
+    fillData(offset * sizeof(T), count * sizeof(T), &value, sizeof(T));
+  }
 }
 
 template <typename InputIterator>
 void Buffer::set(const InputIterator first)
 {
-  assert(isBinded());
-
   using value_t = typename std::iterator_traits<InputIterator>::value_type;
 
-  size_t count = m_size / sizeof(value_t);
-
-  std::vector<value_t> array(count);
-
-  std::copy_n(first, count, array.begin());
-
-  glBufferSubData(
-    getTarget(),
-    0,
-    m_size,
-    static_cast<const void*>(array.data())
-  );
+  set(first, m_size / sizeof(value_t), 0);
 }
 
 template <typename InputIterator>
 void Buffer::set(const InputIterator first, size_t count, size_t offset)
 {
-  assert(isBinded());
-
-  using value_t = typename std::iterator_traits<InputIterator>::value_type;
+  if (count == 0)
+    return;
 
-  size_t size = count * sizeof(value_t);
-  offset *= sizeof(value_t);
+  detail::_set(*this, first, count, offset, detail::_isContiguous<InputIterator>());
+}
 
-  std::vector<value_t> array(count);
+template <typename ContiguousRange>
+void Buffer::set(const ContiguousRange &range, size_t offset)
+{
+  set(range.data(), static_cast<size_t>(range.size()), offset);
+}
 
-  std::copy_n(first, count, array.begin());
+template <typename OutputIterator>
+void Buffer::get(OutputIterator first) const
+{
+  using value_t = typename std::iterator_traits<OutputIterator>::value_type;
 
-  glBufferSubData(
-    getTarget(),
-    offset,
-    size,
-    static_cast<const void*>(array.data())
-  );
+  get(first, m_size / sizeof(value_t), 0);
 }
 
 template <typename OutputIterator>
-void Buffer::get(OutputIterator first) const
+void Buffer::get(OutputIterator first, size_t count, size_t offset) const
 {
-  assert(isBinded());
+  if (count == 0)
+    return;
 
-  using value_t = typename std::iterator_traits<OutputIterator>::value_type;
+  detail::_get(*this, first, count, offset, detail::_isContiguous<OutputIterator>());
+}
 
-  size_t count = m_size / sizeof(value_t);
+template <typename ContiguousRange>
+void Buffer::get(ContiguousRange &range, size_t offset) const
+{
+  get(range.data(), static_cast<size_t>(range.size()), offset);
+}
 
-  std::vector<value_t> array(count);
+//==============//
+// Mapped Range //
+//==============//
 
-  glGetBufferSubData(
-    getTarget(),
-    0,
-    m_size,
-    static_cast<void *>(array.data())
-  );
+template <typename T>
+MappedRange<T>::MappedRange(Buffer &buffer, size_t offset, size_t count, gl::BufferAccessMask access)
+: m_buffer(&buffer), m_data(nullptr), m_offset(offset), m_count(count), m_flushRanges()
+{
+  m_data = static_cast<T*>(buffer.mapData(offset * sizeof(T), count * sizeof(T), access));
+}
 
-  std::copy_n(array.begin(), count, first);
+template <typename T>
+MappedRange<T>::MappedRange(MappedRange &&other)
+: m_buffer(other.m_buffer),
+  m_data(other.m_data),
+  m_offset(other.m_offset),
+  m_count(other.m_count),
+  m_flushRanges(std::move(other.m_flushRanges))
+{
+  other.m_data = nullptr;
 }
 
-template <typename OutputIterator>
-void Buffer::get(OutputIterator first, size_t count, size_t offset) const
+template <typename T>
+MappedRange<T>::~MappedRange()
 {
-  assert(isBinded());
+  unmap();
+}
 
-  using value_t = typename std::iterator_traits<OutputIterator>::value_type;
+template <typename T>
+void MappedRange<T>::flush(size_t first, size_t count)
+{
+  assert(first + count <= m_count);
+
+  if (count > 0)
+    m_flushRanges.push_back(FlushRange(first, count));
+}
+
+template <typename T>
+void MappedRange<T>::flush()
+{
+  if (m_flushRanges.empty())
+    return;
+
+  std::sort(m_flushRanges.begin(), m_flushRanges.end());
 
-  size_t size = count * sizeof(value_t);
-  offset *= sizeof(value_t);
+  size_t first = m_flushRanges.front().first;
+  size_t last = first + m_flushRanges.front().second;
+
+  for (const FlushRange &range : m_flushRanges)
+  {
+    if (range.first > last)
+    {
+      m_buffer->flushData(first * sizeof(T), (last - first) * sizeof(T));
+      first = range.first;
+    }
+
+    last = std::max(last, range.first + range.second);
+  }
+
+  m_buffer->flushData(first * sizeof(T), (last - first) * sizeof(T));
+
+  m_flushRanges.clear();
+}
+
+template <typename T>
+bool MappedRange<T>::unmap()
+{
+  if (!isMapped())
+    return true;
 
-  std::vector<value_t> array(count);
+  flush();
 
-  glGetBufferSubData(
-    getTarget(),
-    offset,
-    size,
-    static_cast<void *>(array.data())
-  );
+  m_data = nullptr;
 
-  std::copy_n(array.begin(), count, first);
+  return m_buffer->unmap();
 }
@@ -0,0 +1,111 @@
+#ifndef __TACOGL_BUFFER_ALLOCATOR__
+#define __TACOGL_BUFFER_ALLOCATOR__
+
+#include <vector>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Buffer.h>
+#include <TacoGL/OffsetAllocator.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Sub-allocates ranges of a few large buffers, so many meshes can share
+   * the same Buffer and be drawn with base vertex or multi-draw commands.
+   */
+  class BufferAllocator
+  {
+  public:
+    struct Allocation
+    {
+      Buffer *buffer; ///< the buffer holding the range.
+      size_t offset; ///< the range offset in the buffer, in bytes.
+      size_t size; ///< the range size, in bytes.
+      size_t page; ///< the buffer index in the allocator.
+      OffsetAllocator::Allocation range;
+
+      bool isValid() const { return buffer != nullptr; }
+    };
+
+    struct Statistics
+    {
+      size_t pageCount;
+      size_t size; ///< the sum of buffers sizes.
+      size_t usedSize;
+      size_t freeSize;
+      size_t largestFreeRegion;
+      size_t freeRegionCount;
+      size_t allocationCount;
+
+      /**
+       * Fraction of the free space not usable by the largest allocation.
+       */
+      float getFragmentation() const
+      {
+        return (freeSize == 0) ? 0.0f : 1.0f - float(largestFreeRegion) / float(freeSize);
+      }
+    };
+
+    /**
+     * @param pageSize the size of each buffer, in bytes.
+     * @param usage OpenGL memory usage of the buffers.
+     * @param alignment the alignment of ranges offsets and sizes, in bytes.
+     *                  Use a multiple of the vertex stride for base vertex
+     *                  draws.
+     */
+    BufferAllocator(size_t pageSize, gl::GLenum usage = gl::GL_STATIC_DRAW, size_t alignment = 256);
+    virtual ~BufferAllocator();
+
+    size_t getPageSize() const { return m_pageSize; }
+    size_t getAlignment() const { return m_alignment; }
+    size_t getPageCount() const { return m_pages.size(); }
+    Buffer & getPage(size_t index) { return *m_pages[index]->buffer; }
+
+    /**
+     * Allocate a range. A new buffer is created when no existing one has
+     * enough space, ranges larger than the page size get their own buffer.
+     *
+     * @param size the range size, in bytes.
+     */
+    Allocation allocate(size_t size);
+
+    /**
+     * Allocate a range for count elements of type T.
+     *
+     * @param count the number of T elements.
+     */
+    template <typename T>
+    Allocation allocate(size_t count)
+    {
+      return allocate(count * sizeof(T));
+    }
+
+    /**
+     * Release a range.
+     *
+     * @param allocation a range returned by allocate.
+     */
+    void free(const Allocation &allocation);
+
+    Statistics getStatistics() const;
+
+  protected:
+    struct Page
+    {
+      Buffer *buffer;
+      OffsetAllocator allocator;
+    };
+
+    std::vector<Page*> m_pages;
+    size_t m_pageSize;
+    gl::GLenum m_usage;
+    size_t m_alignment;
+
+    Page * createPage(size_t size);
+  };
+
+} // end namespace TacoGL
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef __TACOGL_BUFFER_LOADER__
+#define __TACOGL_BUFFER_LOADER__
+
+#include <string>
+#include <functional>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Buffer.h>
+#include <TacoGL/MappedFile.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Upload files into buffers by chunks, without reading them whole in
+   * client memory.
+   *
+   * The file is memory mapped and each chunk is handed to glBufferSubData
+   * straight from the mapping, then released. With prefetching enabled, a
+   * background thread faults in the next chunks while the current one is
+   * uploaded; OpenGL calls stay on the calling thread. The host memory
+   * used stays around (1 + PREFETCH_DEPTH) chunks, whatever the file size.
+   */
+  class BufferLoader
+  {
+  public:
+    /**
+     * Called after each chunk with the number of bytes uploaded and the
+     * total number of bytes.
+     */
+    using ProgressCallback = std::function<void(size_t, size_t)>;
+
+    /**
+     * Number of chunks the prefetching thread runs ahead.
+     */
+    static const size_t PREFETCH_DEPTH = 2;
+
+    /**
+     * @param chunkSize the number of bytes uploaded at once.
+     * @param prefetching true to fault in chunks from a background thread.
+     */
+    BufferLoader(size_t chunkSize = 8 * 1024 * 1024, bool prefetching = true);
+    virtual ~BufferLoader() = default;
+
+    size_t getChunkSize() const { return m_chunkSize; }
+    void setChunkSize(size_t chunkSize);
+
+    bool isPrefetching() const { return m_prefetching; }
+    void setPrefetching(bool prefetching) { m_prefetching = prefetching; }
+
+    void setProgressCallback(const ProgressCallback &callback) { m_progress = callback; }
+
+    /**
+     * Allocate a buffer to the size of a file and upload the file.
+     *
+     * @param path the file to load.
+     * @param buffer the buffer to allocate.
+     * @param usage OpenGL memory usage.
+     * @throw MappedFile::OpenError if the file can not be mapped.
+     */
+    void load(const std::string &path, Buffer &buffer, gl::GLenum usage = gl::GL_STATIC_DRAW);
+
+    /**
+     * Allocate a buffer to the size of a mapped file and upload the file.
+     *
+     * @param file the file to load.
+     * @param buffer the buffer to allocate.
+     * @param usage OpenGL memory usage.
+     */
+    void load(const MappedFile &file, Buffer &buffer, gl::GLenum usage = gl::GL_STATIC_DRAW);
+
+    /**
+     * Upload a range of a mapped file into an allocated buffer (immutable
+     * storages included).
+     *
+     * @param file the file to read from.
+     * @param fileOffset the offset from file start, in bytes.
+     * @param size the number of bytes to upload.
+     * @param buffer the buffer to write into.
+     * @param bufferOffset the offset from buffer start, in bytes.
+     * @see glBufferSubData
+     */
+    void upload(
+      const MappedFile &file,
+      size_t fileOffset,
+      size_t size,
+      Buffer &buffer,
+      size_t bufferOffset = 0
+    );
+
+  protected:
+    size_t m_chunkSize;
+    bool m_prefetching;
+    ProgressCallback m_progress;
+  };
+
+} // end namespace TacoGL
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef __TACOGL_DIRTY_RECTANGLES__
+#define __TACOGL_DIRTY_RECTANGLES__
+
+#include <vector>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Texture.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Accumulate the modified regions of a 2D texture and upload them in one
+   * batch.
+   *
+   * Overlapping and adjacent rectangles of a level are merged into their
+   * bounding box, as long as the box does not cover much more than the
+   * rectangles themselves. flush() uploads each remaining rectangle
+   * straight from the client image, using the unpack pixel store to skip
+   * to the region, so only modified texels are transferred.
+   */
+  class DirtyRectangles
+  {
+  public:
+    struct Rectangle
+    {
+      size_t x;
+      size_t y;
+      size_t width;
+      size_t height;
+
+      size_t area() const { return width * height; }
+    };
+
+    DirtyRectangles();
+    virtual ~DirtyRectangles() = default;
+
+    /**
+     * Retrieve the rectangles waiting for a flush of a level.
+     */
+    const std::vector<Rectangle> & getRectangles(size_t level = 0) const;
+
+    bool isDirty(size_t level = 0) const { return !getRectangles(level).empty(); }
+
+    float getMergeThreshold() const { return m_mergeThreshold; }
+
+    /**
+     * Set how much larger than the sum of two rectangles their bounding box
+     * can be for them to be merged. 1 merges aligned neighbours and
+     * overlapping rectangles, larger values trade bandwidth for fewer
+     * uploads.
+     *
+     * @param threshold the area ratio, at least 1.
+     */
+    void setMergeThreshold(float threshold);
+
+    /**
+     * Record a modified region.
+     *
+     * @param x the region horizontal offset.
+     * @param y the region vertical offset.
+     * @param width the region width.
+     * @param height the region height.
+     * @param level the texture level.
+     */
+    void add(size_t x, size_t y, size_t width, size_t height, size_t level = 0);
+
+    /**
+     * Upload the modified regions of a level from a client image and
+     * forget them. The texture must be binded.
+     *
+     * @param texture the texture to update.
+     * @param format the image format.
+     * @param type the image type.
+     * @param image the whole level image.
+     * @param rowLength the image row length, in pixels.
+     * @param level the texture level.
+     * @return the number of uploads issued.
+     * @see glTexSubImage2D
+     * @see glPixelStore
+     */
+    size_t flush(
+      Texture &texture,
+      gl::GLenum format,
+      gl::GLenum type,
+      const void *image,
+      size_t rowLength,
+      size_t level = 0
+    );
+
+    /**
+     * Forget the modified regions of all levels.
+     */
+    void clear();
+
+  protected:
+    std::vector<std::vector<Rectangle>> m_levels; ///< rectangles per level.
+    float m_mergeThreshold;
+
+    /**
+     * Merge a rectangle with a neighbour, if close enough.
+     * @return true if the rectangles have been merged into rectangle.
+     */
+    bool merge(Rectangle &rectangle, const Rectangle &other) const;
+  };
+
+} // end namespace TacoGL
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef __TACOGL_EXTENSION_REGISTER__
+#define __TACOGL_EXTENSION_REGISTER__
+
+#include <unordered_set>
+
+#include <TacoGL/OpenGL.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Caches the extensions supported by the current OpenGL context.
+   */
+  class ExtensionRegister
+  {
+  public:
+    static std::unordered_set<gl::GLextension> & getExtensions();
+
+    /**
+     * Check if an extension is supported by the current context.
+     * @param ext the extension to check.
+     */
+    static bool isAvaible(gl::GLextension ext);
+
+  protected:
+    static std::unordered_set<gl::GLextension> s_extensions;
+  };
+
+} // end namespace TacoGL
+
+#endif
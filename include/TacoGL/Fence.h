@@ -0,0 +1,74 @@
+#ifndef __TACOGL_FENCE__
+#define __TACOGL_FENCE__
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Wraps an OpenGL fence sync object, used to know when the GPU is done
+   * with the commands issued before it.
+   */
+  class Fence
+  {
+  public:
+    Fence();
+    Fence(const Fence &other) = delete;
+    virtual ~Fence();
+
+    Fence & operator=(const Fence &other) = delete;
+
+    /**
+     * Check if a fence has been inserted and not yet released.
+     */
+    bool isSet() const;
+
+    /**
+     * Check, without blocking, if the GPU reached the fence.
+     * An unset fence is always signaled.
+     *
+     * @see glGetSynciv
+     */
+    bool isSignaled() const;
+
+    /**
+     * Insert the fence in the OpenGL command stream, replacing the
+     * previous one.
+     *
+     * @see glFenceSync
+     */
+    void set();
+
+    /**
+     * Release the fence.
+     *
+     * @see glDeleteSync
+     */
+    void reset();
+
+    /**
+     * Block the client until the GPU reached the fence.
+     *
+     * @param timeout the maximum time to wait, in nanoseconds.
+     * @return true if the fence is signaled.
+     * @see glClientWaitSync
+     */
+    bool wait(gl::GLuint64 timeout = gl::GL_TIMEOUT_IGNORED);
+
+    /**
+     * Make the GPU wait for the fence before executing further commands,
+     * without blocking the client.
+     *
+     * @see glWaitSync
+     */
+    void waitServer();
+
+  protected:
+    gl::GLsync m_sync;
+  };
+
+} // end namespace TacoGL
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef __TACOGL_GPU_VECTOR__
+#define __TACOGL_GPU_VECTOR__
+
+#include <cassert>
+#include <vector>
+#include <algorithm>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Buffer.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Growable array stored in GPU memory.
+   *
+   * Appended elements are batched client side and uploaded in one call by
+   * commit(). Growth is geometric and reallocations copy the contents GPU
+   * side, without CPU round trip. A reallocation replaces the underlying
+   * Buffer, so it must be binded again (and vertex formats re-initialized).
+   */
+  template <typename T>
+  class GpuVector
+  {
+  public:
+    /**
+     * @param usage OpenGL memory usage.
+     * @param capacity the number of elements to reserve.
+     */
+    GpuVector(gl::GLenum usage = gl::GL_DYNAMIC_DRAW, size_t capacity = 0)
+    : m_buffer(nullptr), m_usage(usage), m_size(0), m_capacity(0), m_pending()
+    {
+      reserve(std::max<size_t>(capacity, 1));
+    }
+
+    GpuVector(const GpuVector &other) = delete;
+
+    virtual ~GpuVector()
+    {
+      delete m_buffer;
+    }
+
+    GpuVector & operator=(const GpuVector &other) = delete;
+
+    /**
+     * Retrieve the underlying buffer. Pending elements are not uploaded,
+     * call commit() first.
+     */
+    Buffer & getBuffer() { return *m_buffer; }
+
+    /**
+     * Retrieve the number of elements, pending ones included.
+     */
+    size_t size() const { return m_size + m_pending.size(); }
+
+    /**
+     * Retrieve the number of elements already in GPU memory.
+     */
+    size_t getCommittedSize() const { return m_size; }
+
+    size_t capacity() const { return m_capacity; }
+    bool empty() const { return size() == 0; }
+
+    /**
+     * Append an element, uploaded by the next commit().
+     */
+    void push_back(const T &value)
+    {
+      m_pending.push_back(value);
+    }
+
+    /**
+     * Append elements, uploaded by the next commit().
+     *
+     * @param first the first element to append.
+     * @param last the end of the elements to append.
+     */
+    template <typename InputIterator>
+    void append(InputIterator first, InputIterator last)
+    {
+      m_pending.insert(m_pending.end(), first, last);
+    }
+
+    /**
+     * Update committed elements in place.
+     *
+     * @param first an iterator to read from.
+     * @param count the number of elements to set.
+     * @param offset the first element to update.
+     */
+    template <typename InputIterator>
+    void set(InputIterator first, size_t count, size_t offset)
+    {
+      assert(offset + count <= m_size);
+
+      bool binding = bind();
+      m_buffer->set(first, count, offset);
+      unbind(binding);
+    }
+
+    /**
+     * Upload the pending elements in one call, growing the storage if
+     * needed.
+     *
+     * @see glBufferSubData
+     */
+    void commit()
+    {
+      if (m_pending.empty())
+        return;
+
+      if (size() > m_capacity)
+        reserve(std::max(size(), 2 * m_capacity));
+
+      bool binding = bind();
+      m_buffer->set(m_pending.data(), m_pending.size(), m_size);
+      unbind(binding);
+
+      m_size += m_pending.size();
+      m_pending.clear();
+    }
+
+    /**
+     * Remove all the elements, keeping the storage.
+     */
+    void clear()
+    {
+      m_size = 0;
+      m_pending.clear();
+    }
+
+    /**
+     * Grow the storage to hold at least capacity elements.
+     *
+     * @param capacity the number of elements.
+     */
+    void reserve(size_t capacity)
+    {
+      if (capacity > m_capacity)
+        reallocate(capacity);
+    }
+
+    /**
+     * Shrink the storage to the committed elements.
+     */
+    void shrink_to_fit()
+    {
+      if (m_size < m_capacity)
+        reallocate(std::max<size_t>(m_size, 1));
+    }
+
+  protected:
+    Buffer *m_buffer;
+    gl::GLenum m_usage;
+    size_t m_size; ///< the number of committed elements.
+    size_t m_capacity;
+    std::vector<T> m_pending; ///< elements waiting for commit().
+
+    /**
+     * Bind the buffer for an update, if needed.
+     * @return true if the buffer must be unbinded after the update.
+     */
+    bool bind()
+    {
+      if (Buffer::isDirectStateAccessEnabled() || m_buffer->isBinded())
+        return false;
+
+      m_buffer->bind(gl::GL_COPY_WRITE_BUFFER);
+      return true;
+    }
+
+    void unbind(bool binding)
+    {
+      if (binding)
+        m_buffer->unbind();
+    }
+
+    /**
+     * Move the committed elements to a new storage, GPU side.
+     *
+     * @see glCopyBufferSubData
+     */
+    void reallocate(size_t capacity)
+    {
+      Buffer *buffer = new Buffer();
+      bool binding = !Buffer::isDirectStateAccessEnabled();
+
+      if (binding)
+        buffer->bind(gl::GL_COPY_WRITE_BUFFER);
+
+      buffer->allocate<T>(capacity, m_usage);
+
+      if (m_buffer && m_size > 0)
+      {
+        if (binding)
+          m_buffer->bind(gl::GL_COPY_READ_BUFFER);
+
+        buffer->copy(*m_buffer, 0, 0, m_size * sizeof(T));
+
+        if (binding)
+          m_buffer->unbind();
+      }
+
+      if (binding)
+        buffer->unbind();
+
+      delete m_buffer;
+
+      m_buffer = buffer;
+      m_capacity = capacity;
+    }
+  };
+
+} // end namespace TacoGL
+
+#endif
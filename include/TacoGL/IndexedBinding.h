@@ -0,0 +1,89 @@
+#ifndef __TACOGL_INDEXED_BINDING__
+#define __TACOGL_INDEXED_BINDING__
+
+#include <vector>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Buffer.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Collects the indexed buffer bindings of a pass (uniform blocks, shader
+   * storage blocks...) and binds them at once.
+   *
+   * With ARB_multi_bind, each run of consecutive indices of a target is
+   * binded by a single glBindBuffersRange call.
+   */
+  class IndexedBindingBatch
+  {
+  public:
+    /**
+     * Check if the context supports multi-bind (OpenGL 4.4 or
+     * ARB_multi_bind).
+     */
+    static bool hasMultiBind();
+
+    IndexedBindingBatch() = default;
+    virtual ~IndexedBindingBatch() = default;
+
+    size_t size() const { return m_bindings.size(); }
+    bool empty() const { return m_bindings.empty(); }
+
+    /**
+     * Add a whole buffer binding.
+     *
+     * @param target the indexed target.
+     * @param index the binding point index.
+     * @param buffer the buffer to bind.
+     */
+    void add(gl::GLenum target, size_t index, const Buffer &buffer);
+
+    /**
+     * Add a buffer range binding.
+     *
+     * @param target the indexed target.
+     * @param index the binding point index.
+     * @param buffer the buffer to bind.
+     * @param offset the offset from buffer start, in bytes.
+     * @param size the range size, in bytes.
+     */
+    void add(gl::GLenum target, size_t index, const Buffer &buffer, size_t offset, size_t size);
+
+    /**
+     * Remove all the bindings.
+     */
+    void clear();
+
+    /**
+     * Bind all the added bindings. When an index is added several times,
+     * the last one wins.
+     *
+     * @see glBindBuffersRange
+     * @see glBindBufferRange
+     */
+    void bind();
+
+  protected:
+    struct Binding
+    {
+      gl::GLenum target;
+      gl::GLuint index;
+      gl::GLuint buffer;
+      gl::GLintptr offset;
+      gl::GLsizeiptr size;
+    };
+
+    std::vector<Binding> m_bindings;
+
+    // Reused arrays for glBindBuffersRange.
+    std::vector<gl::GLuint> m_buffers;
+    std::vector<gl::GLintptr> m_offsets;
+    std::vector<gl::GLsizeiptr> m_sizes;
+  };
+
+} // end namespace TacoGL
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef __TACOGL_KTX_LOADER__
+#define __TACOGL_KTX_LOADER__
+
+#include <string>
+#include <functional>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Texture.h>
+#include <TacoGL/MappedFile.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Load block compressed textures from KTX2 containers.
+   *
+   * The file is memory mapped and each level is handed to
+   * glCompressedTexSubImage straight from the mapping, into an immutable
+   * storage. Levels are uploaded from the smallest to the largest and the
+   * base level follows, so a texture streamed with uploadLevel() over
+   * several frames is sampled at its best available resolution. BCn and
+   * ETC2/EAC formats are supported, as long as the driver reports them;
+   * supercompressed files are not.
+   */
+  class KtxLoader
+  {
+  public:
+    /**
+     * Exception for files that are not valid or not supported KTX2
+     * containers.
+     */
+    class FormatError : public Error
+    {
+    public:
+      FormatError(const std::string &path, const std::string &reason) throw();
+      virtual ~FormatError() throw();
+
+      virtual const char* what() const throw();
+
+    protected:
+      std::string m_message;
+    };
+
+    /**
+     * Texture description read from a KTX2 header.
+     */
+    struct Description
+    {
+      gl::GLenum target; ///< 2D, 2D array, cube map or cube map array.
+      gl::GLenum internalFormat;
+      size_t width;
+      size_t height;
+      size_t layers; ///< 1 for non array textures.
+      size_t faces; ///< 6 for cube maps, 1 otherwise.
+      size_t levels;
+    };
+
+    /**
+     * Called after each level with the level uploaded and the number of
+     * levels.
+     */
+    using ProgressCallback = std::function<void(size_t, size_t)>;
+
+    /**
+     * Convert a Vulkan format, as stored in KTX2 headers, into an OpenGL
+     * compressed internal format.
+     *
+     * @param vkFormat the VkFormat value.
+     * @return the internal format, GL_NONE for unsupported formats.
+     */
+    static gl::GLenum getInternalFormat(unsigned int vkFormat);
+
+    /**
+     * Read and check the header of a mapped file.
+     *
+     * @param file the file to read.
+     * @throw FormatError if the file is not supported.
+     */
+    static Description describe(const MappedFile &file);
+
+    /**
+     * @param prefetching true to hint the system about the next level
+     *        while uploading the current one.
+     */
+    KtxLoader(bool prefetching = true);
+    virtual ~KtxLoader() = default;
+
+    bool isPrefetching() const { return m_prefetching; }
+    void setPrefetching(bool prefetching) { m_prefetching = prefetching; }
+
+    void setProgressCallback(const ProgressCallback &callback) { m_progress = callback; }
+
+    /**
+     * Create a texture from a file, all levels uploaded.
+     *
+     * @param path the file to load.
+     * @return a new, unbinded texture.
+     * @throw MappedFile::OpenError if the file can not be mapped.
+     * @throw FormatError if the file is not supported.
+     */
+    Texture* load(const std::string &path);
+
+    /**
+     * Create a texture from a mapped file, all levels uploaded.
+     *
+     * @param file the file to load.
+     * @return a new, unbinded texture.
+     * @throw FormatError if the file is not supported.
+     */
+    Texture* load(const MappedFile &file);
+
+    /**
+     * Allocate the immutable storage of a texture for a mapped file,
+     * without uploading any level.
+     *
+     * @param file the file to load.
+     * @param texture a texture without storage, binded to the
+     *        description target.
+     * @return the file description.
+     * @throw FormatError if the file is not supported.
+     */
+    Description allocate(const MappedFile &file, Texture &texture);
+
+    /**
+     * Upload one level of a mapped file and make it the base level if it
+     * is larger than the current one. Levels are expected from the
+     * smallest (levels - 1) to the largest (0).
+     *
+     * @param file the file to read from.
+     * @param description the file description.
+     * @param texture the allocated texture, binded.
+     * @param level the level to upload.
+     * @throw FormatError if the level lies outside the file.
+     */
+    void uploadLevel(
+      const MappedFile &file,
+      const Description &description,
+      Texture &texture,
+      size_t level
+    );
+
+  protected:
+    bool m_prefetching;
+    ProgressCallback m_progress;
+  };
+
+} // end namespace TacoGL
+
+#endif
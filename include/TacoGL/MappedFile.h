@@ -0,0 +1,99 @@
+#ifndef __TACOGL_MAPPED_FILE__
+#define __TACOGL_MAPPED_FILE__
+
+#include <string>
+
+#include <TacoGL/Error.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Read-only memory mapping of a whole file.
+   *
+   * Pages are loaded by the system on first access, so the host memory
+   * actually used depends on the ranges touched, not on the file size.
+   * prefetch() and release() hint the system about the ranges about to be
+   * read and the ones no longer needed.
+   */
+  class MappedFile
+  {
+  public:
+    /**
+     * Exception for files that can not be opened or mapped.
+     */
+    class OpenError : public Error
+    {
+    public:
+      OpenError(const std::string &path, const std::string &reason) throw();
+      virtual ~OpenError() throw();
+
+      virtual const char* what() const throw();
+
+    protected:
+      std::string m_message;
+    };
+
+    /**
+     * Retrieve the system memory page size, in bytes.
+     */
+    static size_t getPageSize();
+
+    /**
+     * Map a file.
+     *
+     * @param path the file to map.
+     * @throw OpenError if the file can not be opened or mapped.
+     */
+    MappedFile(const std::string &path);
+    MappedFile(const MappedFile &other) = delete;
+    virtual ~MappedFile();
+
+    MappedFile & operator=(const MappedFile &other) = delete;
+
+    const std::string & getPath() const { return m_path; }
+    const unsigned char * data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    /**
+     * Hint that a range is about to be read.
+     *
+     * @param offset the offset from file start, in bytes.
+     * @param size the number of bytes.
+     */
+    void prefetch(size_t offset, size_t size) const;
+
+    /**
+     * Load the pages of a range, reading one byte per page. Meant to be
+     * called from a background thread, ahead of the reader.
+     *
+     * @param offset the offset from file start, in bytes.
+     * @param size the number of bytes.
+     */
+    void touch(size_t offset, size_t size) const;
+
+    /**
+     * Hint that a range will not be read again, its pages can be
+     * reclaimed.
+     *
+     * @param offset the offset from file start, in bytes.
+     * @param size the number of bytes.
+     */
+    void release(size_t offset, size_t size) const;
+
+  protected:
+    std::string m_path;
+    unsigned char *m_data;
+    size_t m_size;
+
+#ifdef _WIN32
+    void *m_file;
+    void *m_mapping;
+#else
+    int m_descriptor;
+#endif
+  };
+
+} // end namespace TacoGL
+
+#endif
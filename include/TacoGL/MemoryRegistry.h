@@ -0,0 +1,111 @@
+#ifndef __TACOGL_MEMORY_REGISTRY__
+#define __TACOGL_MEMORY_REGISTRY__
+
+#include <array>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Object.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Accounts the GPU memory held by TacoGL objects.
+   *
+   * Buffers, textures and renderbuffers report their storage size when
+   * allocated and release it when destroyed. Budgets can be set per
+   * category or for the total, a callback is called when an allocation
+   * exceeds one of them.
+   */
+  class MemoryRegistry
+  {
+  public:
+    enum class Category
+    {
+      BUFFER,
+      TEXTURE,
+      RENDERBUFFER,
+      TOTAL
+    };
+
+    static const size_t CATEGORY_COUNT = 4;
+
+    struct Usage
+    {
+      size_t size; ///< the current size, in bytes.
+      size_t peak; ///< the high-water mark, in bytes.
+      size_t count; ///< the number of objects holding memory.
+      size_t budget; ///< the budget, 0 if none.
+    };
+
+    /**
+     * Called when an allocation makes a category exceed its budget.
+     * Receives the category and its usage.
+     */
+    using BudgetCallback = std::function<void(Category, const Usage &)>;
+
+    static std::string getCategoryName(Category category);
+
+    /**
+     * Report the memory held by an object, replacing its previous report.
+     *
+     * @param category the object category.
+     * @param object the object holding memory.
+     * @param size the memory size, in bytes.
+     */
+    static void update(Category category, const Object *object, size_t size);
+
+    /**
+     * Release the memory held by an object.
+     *
+     * @param object the object, usually being destroyed.
+     */
+    static void remove(const Object *object);
+
+    static const Usage & getUsage(Category category = Category::TOTAL);
+
+    /**
+     * Set the budget of a category.
+     *
+     * @param category the category, TOTAL for all objects.
+     * @param budget the budget in bytes, 0 to disable.
+     */
+    static void setBudget(Category category, size_t budget);
+
+    static void setBudgetCallback(const BudgetCallback &callback);
+
+    /**
+     * Reset the high-water marks to the current sizes.
+     */
+    static void resetPeaks();
+
+    /**
+     * Write a report of the memory usage.
+     *
+     * @param stream the stream to write into.
+     * @param objects true to list every object.
+     */
+    static void dump(std::ostream &stream, bool objects = false);
+
+  protected:
+    struct Entry
+    {
+      Category category;
+      size_t size;
+    };
+
+    static std::unordered_map<const Object*, Entry> s_entries;
+    static std::array<Usage, CATEGORY_COUNT> s_usage;
+    static BudgetCallback s_callback;
+
+    static void add(Category category, size_t size);
+    static void subtract(Category category, size_t size);
+  };
+
+} // end namespace TacoGL
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef __TACOGL_MIPMAP_BUILDER__
+#define __TACOGL_MIPMAP_BUILDER__
+
+#include <string>
+#include <vector>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Texture.h>
+#include <TacoGL/parallel.h>
+
+namespace TacoGL
+{
+
+  /**
+   * CPU builder of RGBA8 mipmap chains, an alternative to
+   * glGenerateMipmap with a fixed and selectable filter.
+   *
+   * Each level is resampled from the previous one by two separable passes
+   * in float. sRGB images are filtered in linear space, alpha is always
+   * linear. Row bands of each pass are split across a ThreadPool and the
+   * filter loops use AVX2 or SSE2 when compiled for them. The result only
+   * depends on the input, whatever the thread count, so chains can be
+   * built offline and cached with save() and load().
+   */
+  class MipmapBuilder
+  {
+  public:
+    /**
+     * Exception for cache files that can not be written or read.
+     */
+    class CacheError : public Error
+    {
+    public:
+      CacheError(const std::string &path, const std::string &reason) throw();
+      virtual ~CacheError() throw();
+
+      virtual const char* what() const throw();
+
+    protected:
+      std::string m_message;
+    };
+
+    enum class Filter
+    {
+      BOX,    ///< average of the covered texels.
+      KAISER, ///< Kaiser windowed sinc, 3 lobes.
+      LANCZOS ///< Lanczos windowed sinc, 3 lobes.
+    };
+
+    /**
+     * One level of a chain, RGBA8 texels tightly packed.
+     */
+    struct Level
+    {
+      size_t width;
+      size_t height;
+      std::vector<unsigned char> pixels;
+    };
+
+    /**
+     * Write a chain to a cache file.
+     *
+     * @param path the file to write.
+     * @param levels the levels to write.
+     * @throw CacheError if the file can not be written.
+     */
+    static void save(const std::string &path, const std::vector<Level> &levels);
+
+    /**
+     * Read a chain from a cache file.
+     *
+     * @param path the file to read.
+     * @return the levels, in the order they were saved.
+     * @throw MappedFile::OpenError if the file can not be mapped.
+     * @throw CacheError if the file is not a valid cache.
+     */
+    static std::vector<Level> load(const std::string &path);
+
+    /**
+     * @param filter the resampling filter.
+     * @param srgb true if the color channels are sRGB encoded.
+     * @param pool the threads to filter with, the global pool if null.
+     */
+    MipmapBuilder(Filter filter = Filter::BOX, bool srgb = false, ThreadPool *pool = nullptr);
+    virtual ~MipmapBuilder() = default;
+
+    Filter getFilter() const { return m_filter; }
+    void setFilter(Filter filter) { m_filter = filter; }
+
+    bool isSrgb() const { return m_srgb; }
+    void setSrgb(bool srgb) { m_srgb = srgb; }
+
+    /**
+     * Build the levels below a base image.
+     *
+     * @param pixels the base level RGBA8 texels, tightly packed.
+     * @param width the base level width.
+     * @param height the base level height.
+     * @param levels the number of levels, base included. 0 for a full
+     *        chain.
+     * @return the levels 1 to levels - 1.
+     */
+    std::vector<Level> build(
+      const unsigned char *pixels,
+      size_t width, size_t height,
+      size_t levels = 0
+    ) const;
+
+    /**
+     * Upload built levels into a 2D texture, from level 1. The base level
+     * internal format is kept, immutable storages are updated with
+     * glTexSubImage2D.
+     *
+     * @param texture the texture, binded, its base level specified.
+     * @param levels the levels returned by build().
+     */
+    static void upload(Texture &texture, const std::vector<Level> &levels);
+
+  protected:
+    Filter m_filter;
+    bool m_srgb;
+    ThreadPool *m_pool;
+  };
+
+} // end namespace TacoGL
+
+#endif
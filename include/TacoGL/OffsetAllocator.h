@@ -0,0 +1,117 @@
+#ifndef __TACOGL_OFFSET_ALLOCATOR__
+#define __TACOGL_OFFSET_ALLOCATOR__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace TacoGL
+{
+
+  /**
+   * Two-Level Segregated Fit allocator over an abstract range of offsets.
+   *
+   * It does not own any memory, it only hands out (offset, size) ranges of
+   * [0, size). Allocation and release are O(1), freed ranges are merged
+   * with their free neighbours.
+   */
+  class OffsetAllocator
+  {
+  public:
+    using NodeIndex = uint32_t;
+
+    static const NodeIndex INVALID_NODE = 0xFFFFFFFF;
+
+    struct Allocation
+    {
+      size_t offset;
+      size_t size;
+      NodeIndex node;
+
+      bool isValid() const { return node != INVALID_NODE; }
+    };
+
+    struct Statistics
+    {
+      size_t size; ///< the managed range size.
+      size_t freeSize; ///< the sum of free ranges sizes.
+      size_t largestFreeRegion; ///< the largest allocatable range.
+      size_t freeRegionCount; ///< the number of free ranges.
+      size_t allocationCount; ///< the number of live allocations.
+
+      /**
+       * Fraction of the free space not usable by the largest allocation,
+       * 0 when all the free space is contiguous.
+       */
+      float getFragmentation() const
+      {
+        return (freeSize == 0) ? 0.0f : 1.0f - float(largestFreeRegion) / float(freeSize);
+      }
+    };
+
+    /**
+     * @param size the size of the managed range.
+     */
+    OffsetAllocator(size_t size);
+    virtual ~OffsetAllocator() = default;
+
+    size_t getSize() const { return m_size; }
+
+    /**
+     * Allocate a range.
+     *
+     * @param size the size of the range.
+     * @return the allocation, invalid if no free range is large enough.
+     */
+    Allocation allocate(size_t size);
+
+    /**
+     * Release a range, merging it with its free neighbours.
+     *
+     * @param allocation an allocation returned by allocate.
+     */
+    void free(const Allocation &allocation);
+
+    /**
+     * Release all allocations.
+     */
+    void reset();
+
+    Statistics getStatistics() const;
+
+  protected:
+    static const size_t SECOND_LEVEL_BITS = 4;
+    static const size_t SECOND_LEVEL_COUNT = 1 << SECOND_LEVEL_BITS;
+    static const size_t FIRST_LEVEL_COUNT = 64 - SECOND_LEVEL_BITS + 1;
+
+    struct Node
+    {
+      size_t offset;
+      size_t size;
+      bool used;
+      NodeIndex previous; ///< physical neighbour before.
+      NodeIndex next; ///< physical neighbour after.
+      NodeIndex previousFree; ///< previous node in the bin.
+      NodeIndex nextFree; ///< next node in the bin.
+    };
+
+    size_t m_size;
+    std::vector<Node> m_nodes;
+    std::vector<NodeIndex> m_unusedNodes; ///< recycled node slots.
+    uint64_t m_firstLevelMap;
+    uint32_t m_secondLevelMap[FIRST_LEVEL_COUNT];
+    NodeIndex m_bins[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT];
+    size_t m_freeSize;
+    size_t m_freeCount;
+    size_t m_allocationCount;
+
+    NodeIndex createNode(size_t offset, size_t size);
+    void destroyNode(NodeIndex node);
+
+    void insertFree(NodeIndex node);
+    void removeFree(NodeIndex node);
+  };
+
+} // end namespace TacoGL
+
+#endif
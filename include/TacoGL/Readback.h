@@ -0,0 +1,127 @@
+#ifndef __TACOGL_READBACK__
+#define __TACOGL_READBACK__
+
+#include <iterator>
+#include <algorithm>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Buffer.h>
+#include <TacoGL/Fence.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Asynchronous readback of GPU memory.
+   *
+   * Data is copied GPU side into a persistently mapped staging buffer and
+   * fenced, the client polls isReady() and reads the mapping once the copy
+   * is done, instead of stalling in glGetBufferSubData. A Readback is meant
+   * to be reused frame after frame.
+   */
+  class Readback
+  {
+  public:
+    /**
+     * Allocate and map the staging storage.
+     *
+     * @param capacity the maximum number of bytes read at once.
+     * @see glBufferStorage
+     */
+    Readback(size_t capacity);
+    virtual ~Readback();
+
+    Buffer & getBuffer() { return m_buffer; }
+    size_t getCapacity() const { return m_buffer.getSize(); }
+
+    /**
+     * Retrieve the number of bytes of the last read.
+     */
+    size_t getSize() const { return m_size; }
+
+    /**
+     * Check if a read has been issued and not yet completed.
+     */
+    bool isPending() const { return m_fence.isSet() && !m_fence.isSignaled(); }
+
+    /**
+     * Check, without blocking, if the data is CPU visible.
+     */
+    bool isReady() const { return m_fence.isSignaled(); }
+
+    /**
+     * Block until the data is CPU visible.
+     *
+     * @param timeout the maximum time to wait, in nanoseconds.
+     * @return true if the data is ready.
+     */
+    bool wait(gl::GLuint64 timeout = gl::GL_TIMEOUT_IGNORED) { return m_fence.wait(timeout); }
+
+    /**
+     * Issue an asynchronous read of buffer data. The source must be binded
+     * unless Direct State Access is enabled.
+     *
+     * @param source the buffer to read from.
+     * @param offset the offset from source start, in bytes.
+     * @param size the number of bytes to read.
+     * @see glCopyBufferSubData
+     */
+    void read(const Buffer &source, size_t offset, size_t size);
+
+    /**
+     * Issue an asynchronous read of count T elements.
+     *
+     * @param source the buffer to read from.
+     * @param count the number of elements to read.
+     * @param offset the offset from source start, in elements.
+     */
+    template <typename T>
+    void read(const Buffer &source, size_t count, size_t offset)
+    {
+      read(source, offset * sizeof(T), count * sizeof(T));
+    }
+
+    /**
+     * Fence the staging buffer after writing into it directly, for
+     * instance with glReadPixels while binded to GL_PIXEL_PACK_BUFFER.
+     *
+     * @param size the number of bytes written.
+     */
+    void fence(size_t size);
+
+    /**
+     * Retrieve the mapped data, waits for the read to complete.
+     */
+    const void* data();
+
+    template <typename T>
+    const T* data()
+    {
+      return static_cast<const T*>(data());
+    }
+
+    /**
+     * Copy the read data, waits for the read to complete.
+     *
+     * @param first an iterator to write into.
+     */
+    template <typename OutputIterator>
+    void get(OutputIterator first)
+    {
+      using value_t = typename std::iterator_traits<OutputIterator>::value_type;
+
+      const value_t *begin = data<value_t>();
+      std::copy(begin, begin + m_size / sizeof(value_t), first);
+    }
+
+  protected:
+    Buffer m_buffer;
+    Fence m_fence;
+    void *m_data; ///< the persistent mapping.
+    size_t m_size;
+  };
+
+} // end namespace TacoGL
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef __TACOGL_SHADOWED_BUFFER__
+#define __TACOGL_SHADOWED_BUFFER__
+
+#include <cassert>
+#include <map>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Buffer.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Fixed size buffer with a client side copy.
+   *
+   * Updates are written to the copy and their ranges are recorded as
+   * dirty. flush() then uploads the dirty ranges, merging the ones closer
+   * than the gap threshold, so many sparse updates become a few larger
+   * glBufferSubData calls.
+   */
+  template <typename T>
+  class ShadowedBuffer
+  {
+  public:
+    /**
+     * @param count the number of elements.
+     * @param usage OpenGL memory usage.
+     */
+    ShadowedBuffer(size_t count, gl::GLenum usage = gl::GL_DYNAMIC_DRAW)
+    : m_buffer(), m_data(count), m_dirty(), m_gapThreshold(0)
+    {
+      bool binding = bind();
+      m_buffer.template allocate<T>(count, usage, m_data.data());
+      unbind(binding);
+    }
+
+    ShadowedBuffer(const ShadowedBuffer &other) = delete;
+    ShadowedBuffer & operator=(const ShadowedBuffer &other) = delete;
+
+    /**
+     * Retrieve the underlying buffer. Dirty ranges are not uploaded, call
+     * flush() first.
+     */
+    Buffer & getBuffer() { return m_buffer; }
+
+    size_t size() const { return m_data.size(); }
+
+    /**
+     * Read an element from the client side copy.
+     */
+    const T & operator[](size_t index) const
+    {
+      assert(index < m_data.size());
+      return m_data[index];
+    }
+
+    /**
+     * Update an element, uploaded by the next flush().
+     */
+    void set(size_t index, const T &value)
+    {
+      assert(index < m_data.size());
+      m_data[index] = value;
+      markDirty(index, 1);
+    }
+
+    /**
+     * Update elements, uploaded by the next flush().
+     *
+     * @param first an iterator to read from.
+     * @param count the number of elements to set.
+     * @param offset the first element to update.
+     */
+    template <typename InputIterator>
+    void set(InputIterator first, size_t count, size_t offset)
+    {
+      assert(offset + count <= m_data.size());
+      std::copy_n(first, count, m_data.begin() + offset);
+      markDirty(offset, count);
+    }
+
+    /**
+     * Give write access to elements of the client side copy. The range is
+     * marked dirty.
+     *
+     * @param offset the first element.
+     * @param count the number of elements.
+     */
+    T * modify(size_t offset, size_t count)
+    {
+      assert(offset + count <= m_data.size());
+      markDirty(offset, count);
+      return m_data.data() + offset;
+    }
+
+    /**
+     * Record a range of the client side copy as dirty.
+     *
+     * @param offset the first element.
+     * @param count the number of elements.
+     */
+    void markDirty(size_t offset, size_t count)
+    {
+      if (count == 0)
+        return;
+
+      size_t begin = offset;
+      size_t end = offset + count;
+      auto it = m_dirty.upper_bound(begin);
+
+      if (it != m_dirty.begin() && std::prev(it)->second >= begin)
+        --it;
+
+      // Absorb the overlapping and adjacent ranges.
+      while (it != m_dirty.end() && it->first <= end)
+      {
+        begin = std::min(begin, it->first);
+        end = std::max(end, it->second);
+        it = m_dirty.erase(it);
+      }
+
+      m_dirty.emplace(begin, end);
+    }
+
+    bool isDirty() const { return !m_dirty.empty(); }
+
+    /**
+     * Retrieve the number of disjoint dirty ranges.
+     */
+    size_t getDirtyRangeCount() const { return m_dirty.size(); }
+
+    size_t getGapThreshold() const { return m_gapThreshold; }
+
+    /**
+     * Set the largest number of clean elements uploaded to merge two dirty
+     * ranges. Larger values trade bandwidth for fewer calls.
+     *
+     * @param elements the number of elements.
+     */
+    void setGapThreshold(size_t elements)
+    {
+      m_gapThreshold = elements;
+    }
+
+    /**
+     * Upload the dirty ranges.
+     *
+     * @return the number of uploads issued.
+     * @see glBufferSubData
+     */
+    size_t flush()
+    {
+      if (m_dirty.empty())
+        return 0;
+
+      size_t uploads = 0;
+      bool binding = bind();
+
+      auto it = m_dirty.begin();
+      size_t begin = it->first;
+      size_t end = it->second;
+
+      for (++it; it != m_dirty.end(); ++it)
+      {
+        if (it->first - end > m_gapThreshold)
+        {
+          upload(begin, end);
+          ++uploads;
+          begin = it->first;
+        }
+
+        end = it->second;
+      }
+
+      upload(begin, end);
+      ++uploads;
+
+      unbind(binding);
+      m_dirty.clear();
+
+      return uploads;
+    }
+
+  protected:
+    Buffer m_buffer;
+    std::vector<T> m_data; ///< client side copy.
+    std::map<size_t, size_t> m_dirty; ///< disjoint dirty ranges, [begin, end) by begin.
+    size_t m_gapThreshold;
+
+    void upload(size_t begin, size_t end)
+    {
+      m_buffer.setData(begin * sizeof(T), (end - begin) * sizeof(T), m_data.data() + begin);
+    }
+
+    /**
+     * Bind the buffer for an update, if needed.
+     * @return true if the buffer must be unbinded after the update.
+     */
+    bool bind()
+    {
+      if (Buffer::isDirectStateAccessEnabled() || m_buffer.isBinded())
+        return false;
+
+      m_buffer.bind(gl::GL_COPY_WRITE_BUFFER);
+      return true;
+    }
+
+    void unbind(bool binding)
+    {
+      if (binding)
+        m_buffer.unbind();
+    }
+  };
+
+} // end namespace TacoGL
+
+#endif
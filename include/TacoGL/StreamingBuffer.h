@@ -0,0 +1,103 @@
+#ifndef __TACOGL_STREAMING_BUFFER__
+#define __TACOGL_STREAMING_BUFFER__
+
+#include <vector>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Buffer.h>
+#include <TacoGL/Fence.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Persistently mapped buffer for per-frame dynamic data.
+   *
+   * The storage is split in segments, one per frame in flight. Each frame
+   * writes into its own segment while the GPU reads the previous ones, a
+   * fence per segment prevents overwriting data still in use.
+   *
+   * Usage:
+   *   stream.begin();
+   *   Vertex *vertices = stream.allocate<Vertex>(count, offset);
+   *   ... write vertices, draw from offset ...
+   *   stream.end();
+   */
+  class StreamingBuffer
+  {
+  public:
+    /**
+     * Allocate and map the streaming storage.
+     *
+     * @param segmentSize the size of a segment, in bytes.
+     * @param segmentCount the number of frames in flight.
+     * @param alignment the alignment of allocations, in bytes.
+     * @see glBufferStorage
+     * @see glMapBufferRange
+     */
+    StreamingBuffer(size_t segmentSize, size_t segmentCount = 3, size_t alignment = 256);
+    virtual ~StreamingBuffer();
+
+    Buffer & getBuffer() { return m_buffer; }
+    const Buffer & getBuffer() const { return m_buffer; }
+
+    size_t getSegmentSize() const { return m_segmentSize; }
+    size_t getSegmentCount() const { return m_fences.size(); }
+    size_t getSegmentIndex() const { return m_segment; }
+
+    /**
+     * Retrieve the offset of the current segment from buffer start.
+     */
+    size_t getSegmentOffset() const { return m_segment * m_segmentSize; }
+
+    /**
+     * Retrieve the number of bytes allocated in the current segment.
+     */
+    size_t getUsedSize() const { return m_used; }
+
+    /**
+     * Start writing a frame, waits until the GPU released the segment.
+     */
+    void begin();
+
+    /**
+     * Allocate memory in the current segment.
+     *
+     * @param size the number of bytes to allocate.
+     * @param offset receives the offset from buffer start, in bytes.
+     * @return a pointer to write into, nullptr if the segment is full.
+     */
+    void* allocate(size_t size, size_t &offset);
+
+    /**
+     * Allocate memory for count elements of type T in the current segment.
+     *
+     * @param count the number of T elements to allocate.
+     * @param offset receives the offset from buffer start, in bytes.
+     * @return a pointer to write into, nullptr if the segment is full.
+     */
+    template <typename T>
+    T* allocate(size_t count, size_t &offset)
+    {
+      return static_cast<T*>(allocate(count * sizeof(T), offset));
+    }
+
+    /**
+     * Finish writing a frame, fences the segment and moves to the next one.
+     */
+    void end();
+
+  protected:
+    Buffer m_buffer;
+    std::vector<Fence> m_fences; ///< a fence per segment.
+    unsigned char *m_data; ///< the persistent mapping.
+    size_t m_segmentSize;
+    size_t m_alignment;
+    size_t m_segment; ///< the current segment.
+    size_t m_used; ///< bytes used in the current segment.
+  };
+
+} // end namespace TacoGL
+
+#endif
@@ -1,7 +1,10 @@
 #ifndef __TACOGL_TEXTURE__
 #define __TACOGL_TEXTURE__
 
+#include <list>
+#include <array>
 #include <vector>
+#include <utility>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -13,48 +16,141 @@
 
 namespace TacoGL
 {
+  class Readback;
+
   /**
    * Manages OpenGL texture bindings.
+   *
+   * Units are allocated among the GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS ones
+   * (unit 0 apart) in least recently used order. Textures stay resident on
+   * their unit until it is reused, binding a resident texture again costs
+   * no OpenGL call. Textures binded to an explicit unit are pinned there
+   * until unbinded. Misses of a batch are binded by glBindTextures /
+   * glBindSamplers, one pair per run of consecutive units, when
+   * multi-bind is supported. The first binding of a texture always goes
+   * through glBindTexture, which creates the texture object.
    */
   class TextureUnitManager
   {
   public:
-    using UnitUsageSet = std::unordered_set<size_t>;
-    using BindingPair = std::pair<size_t, gl::GLenum>;
-    using BindingMap = std::unordered_map<gl::GLuint, BindingPair>;
+    /**
+     * A texture to bind in a batch.
+     */
+    struct Request
+    {
+      gl::GLenum target;
+      gl::GLuint textureId;
+      gl::GLuint samplerId;
+      size_t unit; ///< receives the unit binding.
+    };
 
-    TextureUnitManager() = default;
+    TextureUnitManager();
     virtual ~TextureUnitManager() = default;
 
+    /**
+     * Retrieve the number of managed units, including unit 0. Units are
+     * counted at the first binding, 0 before.
+     */
+    size_t getUnitCount() const;
+
     bool isAvaible(size_t unit) const;
     bool isBinded(gl::GLuint textureId) const;
     size_t getUnitBinding(gl::GLuint textureId) const;
     gl::GLenum getTargetBinding(gl::GLuint textureId) const;
 
     /**
-     * Bind a Texture to an OpenGL unit texture.
-     * @param texture The texture to bind.
+     * Bind a Texture to an OpenGL unit texture, pinned until unbinded.
      * @param unit    The unit where to bind the Texture.
+     * @param target  The texture target.
+     * @param textureId The texture to bind.
+     * @param samplerId The sampler to bind, 0 for none.
      */
     void bind(size_t unit, gl::GLenum target, gl::GLuint textureId, gl::GLuint samplerId = 0);
 
     /**
-     * Bind a texture to the first avaible unit texture.
-     * @param texture the texture to bind.
+     * Bind a texture to a unit, reusing the least recently used one.
+     * @param target the texture target.
+     * @param textureId the texture to bind.
+     * @param samplerId the sampler to bind, 0 for none.
+     * @return the unit binding.
      */
     size_t bind(gl::GLenum target, gl::GLuint textureId, gl::GLuint samplerId = 0);
 
     /**
-     * Unbind a texture.
-     * @param texture The texture to unbind.
+     * Bind several textures, none of them evicting another one.
+     * @param requests the textures to bind, receive their unit.
+     * @see glBindTextures
+     * @see glBindSamplers
+     */
+    void bind(std::vector<Request> &requests);
+
+    /**
+     * Unpin a texture. It stays resident, its unit is reused first.
+     * @param textureId The texture to unbind.
      */
     void unbind(gl::GLuint textureId);
 
+    /**
+     * Unpin all the textures, they stay resident.
+     */
     void unbindAll();
 
+    /**
+     * Forget a deleted texture, without OpenGL call.
+     * @param textureId the deleted texture.
+     */
+    void release(gl::GLuint textureId);
+
+    /**
+     * Make the unit of a texture active, for target based calls.
+     * @param textureId the binded texture.
+     */
+    void activate(gl::GLuint textureId);
+
+    /**
+     * Set the active texture unit, skipping redundant calls.
+     * @see glActiveTexture
+     */
+    void setActiveUnit(size_t unit);
+
   protected:
-    UnitUsageSet m_unitUsage;
-    BindingMap m_unitBinding;
+    static const size_t INVALID_UNIT;
+
+    struct Unit
+    {
+      gl::GLuint textureId; ///< 0 if none.
+      gl::GLenum target;
+      gl::GLuint samplerId;
+      bool pinned;
+    };
+
+    using UnitList = std::list<size_t>;
+    using ResidencyMap = std::unordered_map<gl::GLuint, size_t>;
+
+    std::vector<Unit> m_units;
+    UnitList m_lru; ///< automatic units, least recently used first.
+    std::vector<UnitList::iterator> m_lruPosition; ///< position of each unit in m_lru.
+    ResidencyMap m_residency; ///< unit of each resident texture.
+    std::unordered_set<gl::GLuint> m_created; ///< textures binded once, known to glBindTextures.
+    size_t m_activeUnit;
+
+    /**
+     * Size the unit table at first use, a context is needed.
+     */
+    void initialize();
+
+    void touch(size_t unit);
+
+    /**
+     * Retrieve the least recently used unit neither pinned nor reserved.
+     * @param reserved the units already given in the current batch.
+     */
+    size_t evict(const std::vector<bool> &reserved);
+
+    /**
+     * Record a texture on a unit, replacing the previous one.
+     */
+    void record(size_t unit, gl::GLenum target, gl::GLuint textureId, gl::GLuint samplerId);
   };
 
   class ImageUnitManager
@@ -122,9 +218,69 @@ namespace TacoGL
      */
     static void setActiveTextureUnit(size_t unit);
 
+    using TargetPair = std::pair<Texture*, gl::GLenum>;
+
+    /**
+     * Bind several textures at once, with their sampler.
+     *
+     * @param textures the textures and their targets.
+     * @return the unit of each texture.
+     * @see TextureUnitManager::bind
+     */
+    static std::vector<size_t> bind(const std::vector<TargetPair> &textures);
+
     static const TextureUnitManager& getTextureUnitManager();
     static const ImageUnitManager& getImageUnitManager();
 
+    /**
+     * Compute the number of levels of a full mipmap chain, down to 1x1x1.
+     *
+     * @param width the base level width.
+     * @param height the base level height.
+     * @param depth the base level depth (not the layer count of arrays).
+     */
+    static size_t getMipmapLevelCount(size_t width, size_t height = 1, size_t depth = 1);
+
+    /**
+     * Check if texture regions can be read (OpenGL 4.5 or
+     * ARB_get_texture_sub_image).
+     */
+    static bool hasGetTextureSubImage();
+
+    /**
+     * Check if texture regions can be cleared (OpenGL 4.4 or
+     * ARB_clear_texture).
+     */
+    static bool hasClearTexture();
+
+    /**
+     * Check if internal formats support can be queried (OpenGL 4.3 or
+     * ARB_internalformat_query2).
+     */
+    static bool hasInternalFormatQuery();
+
+    /**
+     * Retrieve the general purpose compressed internal formats the driver
+     * reports. Block compression families (S3TC, RGTC, BPTC, ETC2) are
+     * usually not listed, use isCompressedFormatSupported() for them.
+     *
+     * @see GL_COMPRESSED_TEXTURE_FORMATS
+     */
+    static const std::vector<gl::GLenum>& getCompressedFormats();
+
+    /**
+     * Check if the driver supports a compressed internal format, with
+     * GL_INTERNALFORMAT_SUPPORTED when available, from the version and
+     * extensions of its family otherwise.
+     *
+     * @param internalFormat the compressed internal format.
+     * @param target the texture target.
+     */
+    static bool isCompressedFormatSupported(
+      gl::GLenum internalFormat,
+      gl::GLenum target = gl::GL_TEXTURE_2D
+    );
+
     Texture();
     virtual ~Texture();
 
@@ -133,6 +289,11 @@ namespace TacoGL
     gl::GLenum getTarget() const;
 
     void setSampler(Sampler *sampler) { m_sampler = sampler; }
+
+    /**
+     * Check if the storage has been allocated with glTexStorage.
+     */
+    bool isImmutable() const { return m_immutable; }
     
     /**
      * Bind texture to a texture unit.
@@ -164,6 +325,36 @@ namespace TacoGL
       void *img
     ) const;
 
+    /**
+     * Issue an asynchronous read of a level region into the staging buffer
+     * of a Readback, which is fenced. Poll or wait the Readback, then read
+     * its mapping; the rows are aligned on PACK_ALIGNMENT.
+     *
+     * Without glGetTextureSubImage, only whole levels can be read and the
+     * texture must be binded.
+     *
+     * @param readback the staging buffer to read into.
+     * @param level the texture level.
+     * @param x the region horizontal offset.
+     * @param y the region vertical offset.
+     * @param z the region depth offset (or first layer).
+     * @param width the region width.
+     * @param height the region height.
+     * @param depth the region depth (or layer count).
+     * @param format the pixels format.
+     * @param type the pixels type.
+     * @see glGetTextureSubImage
+     * @see glGetTexImage
+     */
+    void readAsync(
+      Readback &readback,
+      size_t level,
+      size_t x, size_t y, size_t z,
+      size_t width, size_t height, size_t depth,
+      gl::GLenum format,
+      gl::GLenum type
+    ) const;
+
     /**
      * Updates texture data, 1 dimension version.
      * @param level          the texture level (or layer).
@@ -221,6 +412,244 @@ namespace TacoGL
       void *data
     );
 
+    /**
+     * Update a region of a level, 1 dimension version.
+     *
+     * @param level the texture level.
+     * @param x the region offset.
+     * @param width the region width.
+     * @param format the data format.
+     * @param type the data type.
+     * @param data the data to read, laid out by the unpack pixel store.
+     * @see glTexSubImage1D
+     */
+    void setSubData(
+      size_t level,
+      size_t x,
+      size_t width,
+      gl::GLenum format,
+      gl::GLenum type,
+      const void *data
+    );
+
+    /**
+     * Update a region of a level, 2 dimensions version.
+     *
+     * @param level the texture level.
+     * @param x the region horizontal offset.
+     * @param y the region vertical offset.
+     * @param width the region width.
+     * @param height the region height.
+     * @param format the data format.
+     * @param type the data type.
+     * @param data the data to read, laid out by the unpack pixel store.
+     * @see glTexSubImage2D
+     */
+    void setSubData(
+      size_t level,
+      size_t x, size_t y,
+      size_t width, size_t height,
+      gl::GLenum format,
+      gl::GLenum type,
+      const void *data
+    );
+
+    /**
+     * Update a region of a level, 3 dimensions version.
+     *
+     * @param level the texture level.
+     * @param x the region horizontal offset.
+     * @param y the region vertical offset.
+     * @param z the region depth offset (or first layer).
+     * @param width the region width.
+     * @param height the region height.
+     * @param depth the region depth (or layer count).
+     * @param format the data format.
+     * @param type the data type.
+     * @param data the data to read, laid out by the unpack pixel store.
+     * @see glTexSubImage3D
+     */
+    void setSubData(
+      size_t level,
+      size_t x, size_t y, size_t z,
+      size_t width, size_t height, size_t depth,
+      gl::GLenum format,
+      gl::GLenum type,
+      const void *data
+    );
+
+    /**
+     * Specify a compressed level, 1 dimension version. On an immutable
+     * storage the level is updated instead.
+     *
+     * @param level the texture level.
+     * @param internalFormat the compressed internal format.
+     * @param width the level width.
+     * @param size the data size, in bytes.
+     * @param data the compressed blocks.
+     * @see glCompressedTexImage1D
+     */
+    void setCompressedData(
+      size_t level,
+      gl::GLenum internalFormat,
+      size_t width,
+      size_t size,
+      const void *data
+    );
+
+    /**
+     * Specify a compressed level, 2 dimensions version.
+     *
+     * @param level the texture level.
+     * @param internalFormat the compressed internal format.
+     * @param width the level width.
+     * @param height the level height.
+     * @param size the data size, in bytes.
+     * @param data the compressed blocks.
+     * @see glCompressedTexImage2D
+     */
+    void setCompressedData(
+      size_t level,
+      gl::GLenum internalFormat,
+      size_t width, size_t height,
+      size_t size,
+      const void *data
+    );
+
+    /**
+     * Specify a compressed level, 3 dimensions version.
+     *
+     * @param level the texture level.
+     * @param internalFormat the compressed internal format.
+     * @param width the level width.
+     * @param height the level height.
+     * @param depth the level depth (or layer count).
+     * @param size the data size, in bytes.
+     * @param data the compressed blocks.
+     * @see glCompressedTexImage3D
+     */
+    void setCompressedData(
+      size_t level,
+      gl::GLenum internalFormat,
+      size_t width, size_t height, size_t depth,
+      size_t size,
+      const void *data
+    );
+
+    /**
+     * Update a compressed region of a level, 1 dimension version.
+     *
+     * @param level the texture level.
+     * @param x the region offset, a multiple of the block size.
+     * @param width the region width.
+     * @param internalFormat the compressed internal format.
+     * @param size the data size, in bytes.
+     * @param data the compressed blocks.
+     * @see glCompressedTexSubImage1D
+     */
+    void setCompressedSubData(
+      size_t level,
+      size_t x,
+      size_t width,
+      gl::GLenum internalFormat,
+      size_t size,
+      const void *data
+    );
+
+    /**
+     * Update a compressed region of a level, 2 dimensions version.
+     *
+     * @param level the texture level.
+     * @param x the region horizontal offset, a multiple of the block size.
+     * @param y the region vertical offset, a multiple of the block size.
+     * @param width the region width.
+     * @param height the region height.
+     * @param internalFormat the compressed internal format.
+     * @param size the data size, in bytes.
+     * @param data the compressed blocks.
+     * @see glCompressedTexSubImage2D
+     */
+    void setCompressedSubData(
+      size_t level,
+      size_t x, size_t y,
+      size_t width, size_t height,
+      gl::GLenum internalFormat,
+      size_t size,
+      const void *data
+    );
+
+    /**
+     * Update a compressed region of a level, 3 dimensions version. Cube
+     * maps are accepted, z being the first face and depth the face count.
+     *
+     * @param level the texture level.
+     * @param x the region horizontal offset, a multiple of the block size.
+     * @param y the region vertical offset, a multiple of the block size.
+     * @param z the region depth offset (or first layer).
+     * @param width the region width.
+     * @param height the region height.
+     * @param depth the region depth (or layer count).
+     * @param internalFormat the compressed internal format.
+     * @param size the data size, in bytes.
+     * @param data the compressed blocks.
+     * @see glCompressedTexSubImage3D
+     */
+    void setCompressedSubData(
+      size_t level,
+      size_t x, size_t y, size_t z,
+      size_t width, size_t height, size_t depth,
+      gl::GLenum internalFormat,
+      size_t size,
+      const void *data
+    );
+
+    /**
+     * Allocate immutable storage for all levels, 1 dimension version.
+     *
+     * The storage can not be resized, setData then updates the existing
+     * levels with glTexSubImage instead of specifying them again.
+     * Requires OpenGL 4.2 or ARB_texture_storage.
+     *
+     * @param levels the number of levels, 0 for a full mipmap chain.
+     * @param internalFormat the sized internal format.
+     * @param width the base level width.
+     * @see glTexStorage1D
+     */
+    void allocateStorage(size_t levels, gl::GLenum internalFormat, size_t width);
+
+    /**
+     * Allocate immutable storage for all levels, 2 dimensions version
+     * (also 1D arrays, height being the layer count, and cube maps).
+     *
+     * @param levels the number of levels, 0 for a full mipmap chain.
+     * @param internalFormat the sized internal format.
+     * @param width the base level width.
+     * @param height the base level height.
+     * @see glTexStorage2D
+     */
+    void allocateStorage(
+      size_t levels,
+      gl::GLenum internalFormat,
+      size_t width, size_t height
+    );
+
+    /**
+     * Allocate immutable storage for all levels, 3 dimensions version
+     * (also 2D and cube map arrays, depth being the layer count).
+     *
+     * @param levels the number of levels, 0 for a full mipmap chain.
+     * @param internalFormat the sized internal format.
+     * @param width the base level width.
+     * @param height the base level height.
+     * @param depth the base level depth.
+     * @see glTexStorage3D
+     */
+    void allocateStorage(
+      size_t levels,
+      gl::GLenum internalFormat,
+      size_t width, size_t height, size_t depth
+    );
+
     void generateMipmaps();
 
     //--------------------//
@@ -275,6 +704,14 @@ namespace TacoGL
     // TODO: TEXTURE_COMPARE_MODE
     void setCompareFunction(gl::GLenum value);
 
+    /**
+     * Copy the texture and sampling parameters of another texture, and its
+     * sampler. Parameters the source never had are left untouched.
+     *
+     * @param source the texture to copy the parameters from.
+     */
+    void copyParameters(const Texture &source);
+
     //-------------------------//
     // Texture Level Parameter //
     //-------------------------//
@@ -293,10 +730,118 @@ namespace TacoGL
     size_t getBufferSize(size_t level = 0) const;
 
   protected:
+    /**
+     * Client side copy of a parameter, set to the OpenGL default at the
+     * first binding.
+     */
+    template <typename T>
+    struct Shadowed
+    {
+      bool known;
+      T value;
+
+      Shadowed() : known(false), value() {}
+
+      void reset(const T &initial)
+      {
+        known = true;
+        value = initial;
+      }
+    };
+
+    /**
+     * Client side copy of a level specification.
+     */
+    struct LevelState
+    {
+      size_t width;
+      size_t height;
+      size_t depth;
+      gl::GLenum internalFormat; ///< GL_NONE if the level is unknown.
+      bool sized; ///< false until the driver choice of an unsized format is queried.
+    };
+
+    using Color = std::array<gl::GLfloat, 4>;
+
     static TextureUnitManager s_textureUnitManager;
     static ImageUnitManager s_imageUnitManager;
 
     Sampler *m_sampler;
+    bool m_immutable;
+    gl::GLenum m_storageFormat; ///< internal format of the immutable storage.
+    std::vector<size_t> m_levelSizes; ///< memory size of each level.
+    mutable std::vector<LevelState> m_levelStates;
+
+    mutable Shadowed<gl::GLuint> m_baseLevel;
+    mutable Shadowed<gl::GLuint> m_maxLevel;
+    mutable Shadowed<gl::GLenum> m_swizzleR;
+    mutable Shadowed<gl::GLenum> m_swizzleG;
+    mutable Shadowed<gl::GLenum> m_swizzleB;
+    mutable Shadowed<gl::GLenum> m_swizzleA;
+    mutable Shadowed<gl::GLenum> m_magFilter;
+    mutable Shadowed<gl::GLenum> m_minFilter;
+    mutable Shadowed<gl::GLuint> m_minLOD;
+    mutable Shadowed<gl::GLuint> m_maxLOD;
+    mutable Shadowed<gl::GLenum> m_wrapS;
+    mutable Shadowed<gl::GLenum> m_wrapT;
+    mutable Shadowed<gl::GLenum> m_wrapR;
+    mutable Shadowed<Color> m_borderColor;
+    mutable Shadowed<gl::GLenum> m_compareFunction;
+
+    /**
+     * Set the parameter copies to the OpenGL defaults of a target, once.
+     * The texture object is created by its first binding.
+     */
+    void initializeShadows(gl::GLenum target);
+
+    /**
+     * Read a parameter from its copy, querying it if never initialized.
+     */
+    template <gl::GLenum PARAMETER, typename T>
+    T getShadowed(Shadowed<T> &shadow) const;
+
+    /**
+     * Set a parameter, skipping the call if the value is unchanged.
+     */
+    template <gl::GLenum PARAMETER, typename T>
+    void setShadowed(Shadowed<T> &shadow, const T &value);
+
+    /**
+     * Set a parameter to the copy of another texture, if known.
+     */
+    template <gl::GLenum PARAMETER, typename T>
+    void copyShadowed(Shadowed<T> &shadow, const Shadowed<T> &source);
+
+    /**
+     * Retrieve the copy of a level specification, nullptr if unknown.
+     */
+    const LevelState* getLevelState(size_t level) const;
+
+    void setLevelState(
+      size_t level,
+      gl::GLenum internalFormat,
+      size_t width, size_t height, size_t depth
+    );
+
+    /**
+     * Record the memory size of a level and report the texture size to
+     * the MemoryRegistry.
+     */
+    void setLevelSize(size_t level, size_t size);
+
+    /**
+     * Record the specification and memory size of the levels of an
+     * immutable storage.
+     *
+     * @param faces the number of images per level (6 for cube maps),
+     *        counted in the memory size only.
+     */
+    void setStorageLevels(
+      size_t levels,
+      size_t width, size_t height, size_t depth,
+      bool layeredHeight, bool layeredDepth,
+      size_t faces = 1
+    );
   };
   
 } // end namespace GL
@@ -0,0 +1,231 @@
+#ifndef __TACOGL_TEXTURE_ATLAS__
+#define __TACOGL_TEXTURE_ATLAS__
+
+#include <vector>
+#include <unordered_map>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/algebra.h>
+#include <TacoGL/Texture.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Rectangle packer following the skyline bottom-left heuristic.
+   *
+   * The packed area is described by its top outline, a list of horizontal
+   * segments. A rectangle is placed where its top is the lowest, the
+   * outline is then raised over it. Space under the outline is lost until
+   * reset().
+   */
+  class SkylinePacker
+  {
+  public:
+    /**
+     * @param width the packed area width.
+     * @param height the packed area height.
+     */
+    SkylinePacker(size_t width, size_t height);
+    virtual ~SkylinePacker() = default;
+
+    size_t getWidth() const { return m_width; }
+    size_t getHeight() const { return m_height; }
+
+    /**
+     * Retrieve the area covered by packed rectangles.
+     */
+    size_t getUsedArea() const { return m_usedArea; }
+
+    /**
+     * Find room for a rectangle.
+     *
+     * @param width the rectangle width.
+     * @param height the rectangle height.
+     * @param x receives the rectangle horizontal offset.
+     * @param y receives the rectangle vertical offset.
+     * @return false if the rectangle does not fit.
+     */
+    bool pack(size_t width, size_t height, size_t &x, size_t &y);
+
+    /**
+     * Forget all the packed rectangles.
+     */
+    void reset();
+
+  protected:
+    struct Segment
+    {
+      size_t x;
+      size_t y;
+      size_t width;
+    };
+
+    size_t m_width;
+    size_t m_height;
+    size_t m_usedArea;
+    std::vector<Segment> m_skyline; ///< the outline, sorted by x.
+
+    /**
+     * Check if a rectangle fits with its left edge on a segment.
+     * @param y receives the rectangle vertical offset.
+     */
+    bool fit(size_t index, size_t width, size_t height, size_t &y) const;
+  };
+
+  /**
+   * Packs many small images in the layers of a 2D array texture, so they
+   * can be drawn with a single texture binding.
+   *
+   * Images are referred to by handles, their region is queried with
+   * getRegion(), as it changes when the atlas is compacted. Removed images
+   * leave holes until compact() packs the remaining ones again. When an
+   * image does not fit, layers are added; both operations replace the
+   * texture and copy the images GPU side (OpenGL 4.3 or ARB_copy_image).
+   * The parameters and sampler of the previous texture are carried over,
+   * but the texture must be binded again and references returned by
+   * getTexture() are invalidated.
+   */
+  class TextureAtlas
+  {
+  public:
+    using Handle = size_t;
+
+    static const Handle INVALID_HANDLE;
+
+    struct Region
+    {
+      size_t layer;
+      size_t x;
+      size_t y;
+      size_t width;
+      size_t height;
+    };
+
+    /**
+     * @param internalFormat the sized internal format of the layers.
+     * @param width the layers width.
+     * @param height the layers height.
+     * @param layers the initial number of layers.
+     * @param padding the number of texels left between images, against
+     *                filtering bleeding. set() clears them to zero when
+     *                textures can be cleared (Texture::hasClearTexture()),
+     *                they are undefined otherwise.
+     * @see glTexStorage3D
+     */
+    TextureAtlas(
+      gl::GLenum internalFormat,
+      size_t width,
+      size_t height,
+      size_t layers = 1,
+      size_t padding = 1
+    );
+    TextureAtlas(const TextureAtlas &other) = delete;
+    virtual ~TextureAtlas();
+
+    TextureAtlas & operator=(const TextureAtlas &other) = delete;
+
+    /**
+     * Retrieve the layers texture, replaced by add() and compact().
+     */
+    Texture & getTexture() { return *m_texture; }
+    size_t getWidth() const { return m_width; }
+    size_t getHeight() const { return m_height; }
+    size_t getLayerCount() const { return m_packers.size(); }
+    size_t getImageCount() const { return m_regions.size(); }
+
+    /**
+     * Retrieve the fraction of the packed area lost by removed images.
+     */
+    float getFragmentation() const;
+
+    /**
+     * Reserve room for an image.
+     *
+     * @param width the image width.
+     * @param height the image height.
+     * @return the image handle.
+     */
+    Handle add(size_t width, size_t height);
+
+    /**
+     * Add an image.
+     *
+     * @param width the image width.
+     * @param height the image height.
+     * @param format the data format.
+     * @param type the data type.
+     * @param data the image to upload.
+     * @return the image handle.
+     * @see glTexSubImage3D
+     */
+    Handle add(
+      size_t width,
+      size_t height,
+      gl::GLenum format,
+      gl::GLenum type,
+      const void *data
+    );
+
+    /**
+     * Upload the content of an image, and clear its padding.
+     *
+     * @see glTexSubImage3D
+     * @see glClearTexSubImage
+     */
+    void set(Handle handle, gl::GLenum format, gl::GLenum type, const void *data);
+
+    /**
+     * Remove an image, its room is reused after compact().
+     */
+    void remove(Handle handle);
+
+    bool contains(Handle handle) const { return m_regions.count(handle) > 0; }
+
+    const Region & getRegion(Handle handle) const;
+
+    /**
+     * Retrieve the texture coordinates of an image.
+     *
+     * @return the (u0, v0, u1, v1) rectangle, layer apart.
+     */
+    Vector4 getCoordinates(Handle handle) const;
+
+    /**
+     * Pack the remaining images again, recovering the room of removed
+     * ones. Images are copied GPU side.
+     *
+     * @see glCopyImageSubData
+     */
+    void compact();
+
+  protected:
+    Texture *m_texture;
+    gl::GLenum m_internalFormat;
+    size_t m_width;
+    size_t m_height;
+    size_t m_padding;
+    std::vector<SkylinePacker> m_packers; ///< a packer per layer.
+    std::unordered_map<Handle, Region> m_regions;
+    Handle m_nextHandle;
+
+    /**
+     * Find room for an image in existing layers.
+     */
+    bool pack(size_t width, size_t height, Region &region);
+
+    /**
+     * Create the layers texture, with the parameters of the current one.
+     */
+    Texture* createTexture(size_t layers) const;
+
+    /**
+     * Move to a texture with more layers, keeping the images in place.
+     */
+    void grow(size_t layers);
+  };
+
+} // end namespace TacoGL
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __TACOGL_TEXTURE_READER__
+#define __TACOGL_TEXTURE_READER__
+
+#include <vector>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Texture.h>
+#include <TacoGL/Readback.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Asynchronous texture reads through a ring of PIXEL_PACK staging
+   * buffers.
+   *
+   * Each read packs into the next Readback of the ring and returns it as
+   * the handle to poll, wait and read in place. A handle stays valid until
+   * the ring wraps around to it, which waits for its read to complete, so
+   * the ring size is the number of reads in flight.
+   *
+   * Usage:
+   *   Readback &frame = reader.read(texture, 0, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE);
+   *   ... render the next frames ...
+   *   if (frame.isReady()) process(frame.data<unsigned char>());
+   */
+  class TextureReader
+  {
+  public:
+    /**
+     * Allocate and map the staging buffers.
+     *
+     * @param capacity the maximum number of bytes of a read.
+     * @param count the number of reads in flight.
+     */
+    TextureReader(size_t capacity, size_t count = 3);
+    TextureReader(const TextureReader &other) = delete;
+    virtual ~TextureReader();
+
+    TextureReader & operator=(const TextureReader &other) = delete;
+
+    size_t getCapacity() const { return m_readbacks.front()->getCapacity(); }
+    size_t getCount() const { return m_readbacks.size(); }
+
+    /**
+     * Read a 2D region of a level.
+     *
+     * @see Texture::readAsync
+     */
+    Readback& read(
+      const Texture &texture,
+      size_t level,
+      size_t x, size_t y,
+      size_t width, size_t height,
+      gl::GLenum format,
+      gl::GLenum type
+    );
+
+    /**
+     * Read a 3D region of a level, or a range of layers.
+     *
+     * @see Texture::readAsync
+     */
+    Readback& read(
+      const Texture &texture,
+      size_t level,
+      size_t x, size_t y, size_t z,
+      size_t width, size_t height, size_t depth,
+      gl::GLenum format,
+      gl::GLenum type
+    );
+
+  protected:
+    std::vector<Readback*> m_readbacks;
+    size_t m_next; ///< the next readback to use, the oldest.
+  };
+
+} // end namespace TacoGL
+
+#endif
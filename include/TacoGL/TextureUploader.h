@@ -0,0 +1,152 @@
+#ifndef __TACOGL_TEXTURE_UPLOADER__
+#define __TACOGL_TEXTURE_UPLOADER__
+
+#include <vector>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/Error.h>
+#include <TacoGL/Buffer.h>
+#include <TacoGL/Fence.h>
+#include <TacoGL/Texture.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Asynchronous texture uploads through a ring of pixel buffers.
+   *
+   * Each slot is a persistently mapped PIXEL_UNPACK buffer. The OpenGL
+   * thread acquires a slot and hands its memory to a decoder thread, which
+   * writes pixels without any OpenGL call. Back on the OpenGL thread,
+   * upload() issues glTexSubImage from the slot and submit() fences it, the
+   * slot is recycled once the GPU consumed it. Decoding, copy and transfer
+   * of successive images overlap instead of being serialized.
+   *
+   * Usage:
+   *   TextureUploader::Slot &slot = uploader.acquire();       // GL thread
+   *   decode(image, slot.data(), slot.size());                 // any thread
+   *   uploader.upload(slot, 0, texture, 0, 0, 0, w, h, format, type);
+   *   uploader.submit(slot);                                   // GL thread
+   */
+  class TextureUploader
+  {
+  public:
+    /**
+     * Staging memory of an upload.
+     */
+    class Slot
+    {
+    public:
+      Slot(const Slot &other) = delete;
+      Slot & operator=(const Slot &other) = delete;
+
+      void* data() const { return m_data; }
+      size_t size() const { return m_buffer.getSize(); }
+      size_t getIndex() const { return m_index; }
+
+    protected:
+      friend class TextureUploader;
+
+      Buffer m_buffer;
+      Fence m_fence; ///< set once the slot uploads are issued.
+      void *m_data; ///< the persistent mapping.
+      size_t m_index;
+      bool m_acquired;
+
+      Slot(size_t index, size_t size);
+      virtual ~Slot();
+    };
+
+    /**
+     * Allocate and map the staging slots.
+     *
+     * @param slotSize the size of each slot, in bytes.
+     * @param slotCount the number of slots.
+     * @see glBufferStorage
+     */
+    TextureUploader(size_t slotSize, size_t slotCount = 4);
+    TextureUploader(const TextureUploader &other) = delete;
+    virtual ~TextureUploader();
+
+    TextureUploader & operator=(const TextureUploader &other) = delete;
+
+    size_t getSlotSize() const { return m_slotSize; }
+    size_t getSlotCount() const { return m_slots.size(); }
+
+    /**
+     * Acquire a slot released by the GPU, without blocking.
+     *
+     * @return the slot, nullptr if all slots are in use.
+     */
+    Slot* tryAcquire();
+
+    /**
+     * Acquire a slot, waiting for the GPU to release the oldest one if
+     * needed. At least one slot must not be acquired.
+     */
+    Slot& acquire();
+
+    /**
+     * Update a texture region from a slot, 2 dimensions version. The
+     * texture must be binded.
+     *
+     * @param slot the acquired slot holding the pixels.
+     * @param offset the pixels offset from slot start, in bytes.
+     * @param texture the texture to update.
+     * @param level the texture level.
+     * @param x the region horizontal offset.
+     * @param y the region vertical offset.
+     * @param width the region width.
+     * @param height the region height.
+     * @param format the pixels format.
+     * @param type the pixels type.
+     * @see glTexSubImage2D
+     */
+    void upload(
+      Slot &slot,
+      size_t offset,
+      Texture &texture,
+      size_t level,
+      size_t x, size_t y,
+      size_t width, size_t height,
+      gl::GLenum format,
+      gl::GLenum type
+    );
+
+    /**
+     * Update a texture region from a slot, 3 dimensions version.
+     *
+     * @see glTexSubImage3D
+     */
+    void upload(
+      Slot &slot,
+      size_t offset,
+      Texture &texture,
+      size_t level,
+      size_t x, size_t y, size_t z,
+      size_t width, size_t height, size_t depth,
+      gl::GLenum format,
+      gl::GLenum type
+    );
+
+    /**
+     * Fence the uploads issued from a slot and give it back to the ring.
+     */
+    void submit(Slot &slot);
+
+    /**
+     * Give a slot back to the ring without upload.
+     */
+    void cancel(Slot &slot);
+
+  protected:
+    std::vector<Slot*> m_slots;
+    size_t m_slotSize;
+    size_t m_next; ///< the slot to try first, the oldest submitted.
+
+    Slot& take(Slot &slot);
+  };
+
+} // end namespace TacoGL
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef __TACOGL_FORMAT__
+#define __TACOGL_FORMAT__
+
+#include <cstddef>
+
+#include <TacoGL/OpenGL.h>
+#include <TacoGL/algebra.h>
+
+namespace TacoGL
+{
+
+  /**
+   * Retrieve the sized internal format an unsized one usually resolves to
+   * (GL_RGBA8 for GL_RGBA). Generic compressed formats resolve to their
+   * uncompressed equivalent, an upper bound of the driver choice.
+   *
+   * @param internalFormat the internal format.
+   * @return the sized format, internalFormat if already sized.
+   */
+  gl::GLenum getSizedFormat(gl::GLenum internalFormat);
+
+  /**
+   * Retrieve the number of bits per texel of an internal format, unsized
+   * formats being resolved by getSizedFormat. Compressed formats report
+   * their average rate (4 bits for BC1).
+   *
+   * @param internalFormat the internal format.
+   * @return the number of bits, 0 for unknown formats.
+   */
+  size_t getFormatBits(gl::GLenum internalFormat);
+
+  /**
+   * Check if an internal format is block compressed.
+   *
+   * @param internalFormat the internal format.
+   */
+  bool isCompressedFormat(gl::GLenum internalFormat);
+
+  /**
+   * Compute the memory size of an image.
+   *
+   * @param internalFormat the sized internal format.
+   * @param width the image width.
+   * @param height the image height.
+   * @param depth the image depth.
+   * @return the size in bytes, compressed images are rounded up to 4x4
+   *         blocks.
+   */
+  size_t getImageSize(
+    gl::GLenum internalFormat,
+    size_t width,
+    size_t height = 1,
+    size_t depth = 1
+  );
+
+  /**
+   * Compute the client size of a pixel, as transferred by glTexImage or
+   * glReadPixels.
+   *
+   * @param format the pixel format (RED, RGBA, BGRA_INTEGER...).
+   * @param type the pixel type, packed types included.
+   * @return the size in bytes, 0 for unknown combinations.
+   */
+  size_t getPixelSize(gl::GLenum format, gl::GLenum type);
+
+  /**
+   * Pixel transfer description of a client type, as read by
+   * glClearBufferSubData or glTexImage.
+   */
+  template <
+    gl::GLenum INTERNAL_FORMAT,
+    gl::GLenum FORMAT,
+    gl::GLenum TYPE
+  >
+  struct ClientFormatTraits
+  {
+    static constexpr gl::GLenum internalFormat = INTERNAL_FORMAT;
+    static constexpr gl::GLenum format = FORMAT;
+    static constexpr gl::GLenum type = TYPE;
+  };
+
+  /**
+   * Map a client type to its sized internal format, format and type.
+   * Undefined for types without a matching format.
+   *
+   * @tparam T the client type.
+   */
+  template <typename T>
+  struct ClientFormat;
+
+  template <>
+  struct ClientFormat<gl::GLbyte>
+  : ClientFormatTraits<gl::GL_R8I, gl::GL_RED_INTEGER, gl::GL_BYTE> {};
+
+  template <>
+  struct ClientFormat<gl::GLubyte>
+  : ClientFormatTraits<gl::GL_R8UI, gl::GL_RED_INTEGER, gl::GL_UNSIGNED_BYTE> {};
+
+  template <>
+  struct ClientFormat<gl::GLshort>
+  : ClientFormatTraits<gl::GL_R16I, gl::GL_RED_INTEGER, gl::GL_SHORT> {};
+
+  template <>
+  struct ClientFormat<gl::GLushort>
+  : ClientFormatTraits<gl::GL_R16UI, gl::GL_RED_INTEGER, gl::GL_UNSIGNED_SHORT> {};
+
+  template <>
+  struct ClientFormat<gl::GLint>
+  : ClientFormatTraits<gl::GL_R32I, gl::GL_RED_INTEGER, gl::GL_INT> {};
+
+  template <>
+  struct ClientFormat<gl::GLuint>
+  : ClientFormatTraits<gl::GL_R32UI, gl::GL_RED_INTEGER, gl::GL_UNSIGNED_INT> {};
+
+  template <>
+  struct ClientFormat<gl::GLfloat>
+  : ClientFormatTraits<gl::GL_R32F, gl::GL_RED, gl::GL_FLOAT> {};
+
+  template <>
+  struct ClientFormat<Vector2>
+  : ClientFormatTraits<gl::GL_RG32F, gl::GL_RG, gl::GL_FLOAT> {};
+
+  template <>
+  struct ClientFormat<Vector3>
+  : ClientFormatTraits<gl::GL_RGB32F, gl::GL_RGB, gl::GL_FLOAT> {};
+
+  template <>
+  struct ClientFormat<Vector4>
+  : ClientFormatTraits<gl::GL_RGBA32F, gl::GL_RGBA, gl::GL_FLOAT> {};
+
+  template <>
+  struct ClientFormat<Vector2i>
+  : ClientFormatTraits<gl::GL_RG32I, gl::GL_RG_INTEGER, gl::GL_INT> {};
+
+  template <>
+  struct ClientFormat<Vector3i>
+  : ClientFormatTraits<gl::GL_RGB32I, gl::GL_RGB_INTEGER, gl::GL_INT> {};
+
+  template <>
+  struct ClientFormat<Vector4i>
+  : ClientFormatTraits<gl::GL_RGBA32I, gl::GL_RGBA_INTEGER, gl::GL_INT> {};
+
+  template <>
+  struct ClientFormat<Vector2ui>
+  : ClientFormatTraits<gl::GL_RG32UI, gl::GL_RG_INTEGER, gl::GL_UNSIGNED_INT> {};
+
+  template <>
+  struct ClientFormat<Vector3ui>
+  : ClientFormatTraits<gl::GL_RGB32UI, gl::GL_RGB_INTEGER, gl::GL_UNSIGNED_INT> {};
+
+  template <>
+  struct ClientFormat<Vector4ui>
+  : ClientFormatTraits<gl::GL_RGBA32UI, gl::GL_RGBA_INTEGER, gl::GL_UNSIGNED_INT> {};
+
+} // end namespace TacoGL
+
+#endif
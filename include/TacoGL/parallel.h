@@ -0,0 +1,85 @@
+#ifndef __TACOGL_PARALLEL__
+#define __TACOGL_PARALLEL__
+
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <atomic>
+
+namespace TacoGL
+{
+
+  /**
+   * Fixed set of worker threads splitting index ranges.
+   *
+   * run() hands ranges of [0, count) to the workers and to the calling
+   * thread, and returns once all of them are processed. Tasks must not
+   * call OpenGL, the context is bound to the calling thread only. A run()
+   * issued from a task is processed serially by that task's thread.
+   */
+  class ThreadPool
+  {
+  public:
+    /**
+     * Called with a range [first, last) of indices.
+     */
+    using Task = std::function<void(size_t, size_t)>;
+
+    /**
+     * Retrieve the pool shared by the library, one thread per core.
+     */
+    static ThreadPool& getGlobal();
+
+    /**
+     * @param threads the number of threads, calling thread included. 0 for
+     *        one thread per core.
+     */
+    ThreadPool(size_t threads = 0);
+    ThreadPool(const ThreadPool &other) = delete;
+    virtual ~ThreadPool();
+
+    ThreadPool & operator=(const ThreadPool &other) = delete;
+
+    /**
+     * Retrieve the number of threads, calling thread included.
+     */
+    size_t getThreadCount() const { return m_workers.size() + 1; }
+
+    /**
+     * Process [0, count) by ranges of grain indices, blocking.
+     *
+     * @param count the number of indices.
+     * @param task the task called for each range.
+     * @param grain the number of indices per range.
+     * @throw the first exception thrown by a task, once all ranges are
+     *        done.
+     */
+    void run(size_t count, const Task &task, size_t grain = 1);
+
+  protected:
+    std::vector<std::thread> m_workers;
+    std::mutex m_runMutex; ///< one run at a time.
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    bool m_stopped;
+    size_t m_generation; ///< incremented by each run.
+    size_t m_active; ///< the number of workers inside the current run.
+
+    const Task *m_task;
+    size_t m_count;
+    size_t m_grain;
+    std::atomic<size_t> m_next; ///< the first index not handed yet.
+    std::exception_ptr m_error;
+
+    void work();
+    void process();
+  };
+
+} // end namespace TacoGL
+
+#endif
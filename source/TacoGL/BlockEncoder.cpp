@@ -0,0 +1,680 @@
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <TacoGL/BlockEncoder.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+namespace
+{
+  /**
+   * 4x4 RGBA8 texels, rows from the first one.
+   */
+  struct _Block
+  {
+    alignas(32) uint8_t texels[64];
+
+    const uint8_t* operator[](size_t i) const { return texels + 4 * i; }
+  };
+
+  void _loadBlock(
+    const unsigned char *pixels,
+    size_t width, size_t height,
+    size_t rowLength,
+    size_t blockX, size_t blockY,
+    _Block &block
+  )
+  {
+    for (size_t y = 0; y < 4; ++y)
+    {
+      size_t row = std::min(blockY * 4 + y, height - 1);
+
+      for (size_t x = 0; x < 4; ++x)
+      {
+        size_t column = std::min(blockX * 4 + x, width - 1);
+        std::memcpy(block.texels + 4 * (4 * y + x), pixels + 4 * (row * rowLength + column), 4);
+      }
+    }
+  }
+
+  //---------//
+  // Kernels //
+  //---------//
+
+  /**
+   * Compute the per channel minimum and maximum of a block.
+   */
+  void _minMax(const _Block &block, uint8_t min[4], uint8_t max[4])
+  {
+#if defined(__AVX2__)
+    __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.texels));
+    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.texels + 32));
+
+    __m256i min8 = _mm256_min_epu8(a, b);
+    __m256i max8 = _mm256_max_epu8(a, b);
+    __m128i low = _mm_min_epu8(_mm256_castsi256_si128(min8), _mm256_extracti128_si256(min8, 1));
+    __m128i high = _mm_max_epu8(_mm256_castsi256_si128(max8), _mm256_extracti128_si256(max8, 1));
+#elif defined(__SSE2__)
+    const __m128i *texels = reinterpret_cast<const __m128i*>(block.texels);
+    __m128i t0 = _mm_load_si128(texels);
+    __m128i t1 = _mm_load_si128(texels + 1);
+    __m128i t2 = _mm_load_si128(texels + 2);
+    __m128i t3 = _mm_load_si128(texels + 3);
+
+    __m128i low = _mm_min_epu8(_mm_min_epu8(t0, t1), _mm_min_epu8(t2, t3));
+    __m128i high = _mm_max_epu8(_mm_max_epu8(t0, t1), _mm_max_epu8(t2, t3));
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    // 4 texels left, fold them into the first one.
+    low = _mm_min_epu8(low, _mm_srli_si128(low, 8));
+    low = _mm_min_epu8(low, _mm_srli_si128(low, 4));
+    high = _mm_max_epu8(high, _mm_srli_si128(high, 8));
+    high = _mm_max_epu8(high, _mm_srli_si128(high, 4));
+
+    uint32_t packedMin = static_cast<uint32_t>(_mm_cvtsi128_si32(low));
+    uint32_t packedMax = static_cast<uint32_t>(_mm_cvtsi128_si32(high));
+    std::memcpy(min, &packedMin, 4);
+    std::memcpy(max, &packedMax, 4);
+#else
+    std::memcpy(min, block[0], 4);
+    std::memcpy(max, block[0], 4);
+
+    for (size_t i = 1; i < 16; ++i)
+    {
+      for (size_t c = 0; c < 4; ++c)
+      {
+        min[c] = std::min(min[c], block[i][c]);
+        max[c] = std::max(max[c], block[i][c]);
+      }
+    }
+#endif
+  }
+
+  /**
+   * Compute the dot product of each texel with an axis.
+   *
+   * @param axis the RGBA weights, within [-255, 255].
+   */
+  void _project(const _Block &block, const int16_t axis[4], int32_t dots[16])
+  {
+#if defined(__AVX2__)
+    __m256i zero = _mm256_setzero_si256();
+    __m256i weights = _mm256_set_epi16(
+      axis[3], axis[2], axis[1], axis[0], axis[3], axis[2], axis[1], axis[0],
+      axis[3], axis[2], axis[1], axis[0], axis[3], axis[2], axis[1], axis[0]
+    );
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+      __m256i texels = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.texels) + i);
+
+      // Texels 0 1 4 5 and 2 3 6 7, per 128 bits lane.
+      __m256i low = _mm256_madd_epi16(_mm256_unpacklo_epi8(texels, zero), weights);
+      __m256i high = _mm256_madd_epi16(_mm256_unpackhi_epi8(texels, zero), weights);
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dots + 8 * i), _mm256_hadd_epi32(low, high));
+    }
+#elif defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+    __m128i weights = _mm_set_epi16(
+      axis[3], axis[2], axis[1], axis[0], axis[3], axis[2], axis[1], axis[0]
+    );
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+      __m128i texels = _mm_load_si128(reinterpret_cast<const __m128i*>(block.texels) + i);
+
+      __m128 low = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(texels, zero), weights));
+      __m128 high = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(texels, zero), weights));
+
+      // Add the RG and BA halves of each texel.
+      __m128i even = _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)));
+      __m128i odd = _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)));
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dots + 4 * i), _mm_add_epi32(even, odd));
+    }
+#else
+    for (size_t i = 0; i < 16; ++i)
+    {
+      dots[i] = block[i][0] * axis[0] + block[i][1] * axis[1]
+        + block[i][2] * axis[2] + block[i][3] * axis[3];
+    }
+#endif
+  }
+
+  //--------------//
+  // Color blocks //
+  //--------------//
+
+  uint16_t _to565(const float color[3])
+  {
+    int r = static_cast<int>(std::lround(std::min(std::max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f));
+    int g = static_cast<int>(std::lround(std::min(std::max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f));
+    int b = static_cast<int>(std::lround(std::min(std::max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f));
+
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+  }
+
+  void _from565(uint16_t packed, int color[3])
+  {
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+  }
+
+  bool _isTransparent(const _Block &block, size_t i, bool punchThrough)
+  {
+    return punchThrough && block[i][3] < 128;
+  }
+
+  /**
+   * Select the index of each texel for the given endpoints.
+   *
+   * @param punchThrough true for the 3 colors mode, transparent texels
+   *        taking index 3.
+   * @return the squared error over the opaque texels.
+   */
+  int _selectColorIndices(
+    const _Block &block,
+    uint16_t c0, uint16_t c1,
+    bool punchThrough,
+    uint8_t indices[16]
+  )
+  {
+    int p0[3], p1[3];
+    _from565(c0, p0);
+    _from565(c1, p1);
+
+    int palette[4][3];
+    for (size_t c = 0; c < 3; ++c)
+    {
+      palette[0][c] = p0[c];
+      palette[1][c] = p1[c];
+      palette[2][c] = punchThrough ? (p0[c] + p1[c]) / 2 : (2 * p0[c] + p1[c]) / 3;
+      palette[3][c] = punchThrough ? 0 : (p0[c] + 2 * p1[c]) / 3;
+    }
+
+    int16_t axis[4] = {
+      static_cast<int16_t>(p0[0] - p1[0]),
+      static_cast<int16_t>(p0[1] - p1[1]),
+      static_cast<int16_t>(p0[2] - p1[2]),
+      0
+    };
+
+    int32_t dots[16];
+    _project(block, axis, dots);
+
+    int d0 = p0[0] * axis[0] + p0[1] * axis[1] + p0[2] * axis[2];
+    int d1 = p1[0] * axis[0] + p1[1] * axis[1] + p1[2] * axis[2];
+    int length = d0 - d1;
+
+    // Position along the axis, from c1 to c0, to index.
+    static const uint8_t steps4[4] = {1, 3, 2, 0};
+    static const uint8_t steps3[3] = {1, 2, 0};
+    int steps = punchThrough ? 2 : 3;
+
+    int error = 0;
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+      if (_isTransparent(block, i, punchThrough))
+      {
+        indices[i] = 3;
+        continue;
+      }
+
+      int step = 0;
+
+      if (length > 0)
+      {
+        step = ((dots[i] - d1) * steps * 2 + length) / (2 * length);
+        step = std::min(std::max(step, 0), steps);
+      }
+
+      indices[i] = (length > 0) ? (punchThrough ? steps3[step] : steps4[step]) : 0;
+
+      for (size_t c = 0; c < 3; ++c)
+      {
+        int difference = block[i][c] - palette[indices[i]][c];
+        error += difference * difference;
+      }
+    }
+
+    return error;
+  }
+
+  /**
+   * Fit endpoints to the selected indices, by least squares.
+   *
+   * @return false if the system is degenerate.
+   */
+  bool _refineEndpoints(
+    const _Block &block,
+    const uint8_t indices[16],
+    bool punchThrough,
+    float e0[3], float e1[3]
+  )
+  {
+    static const float weights4[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+    static const float weights3[4] = {1.0f, 0.0f, 0.5f, 0.0f};
+    const float *weights = punchThrough ? weights3 : weights4;
+
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[3] = {0.0f, 0.0f, 0.0f};
+    float bx[3] = {0.0f, 0.0f, 0.0f};
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+      if (_isTransparent(block, i, punchThrough))
+        continue;
+
+      float a = weights[indices[i]];
+      float b = 1.0f - a;
+
+      aa += a * a;
+      bb += b * b;
+      ab += a * b;
+
+      for (size_t c = 0; c < 3; ++c)
+      {
+        ax[c] += a * block[i][c];
+        bx[c] += b * block[i][c];
+      }
+    }
+
+    float determinant = aa * bb - ab * ab;
+
+    if (std::fabs(determinant) < 1e-6f)
+      return false;
+
+    for (size_t c = 0; c < 3; ++c)
+    {
+      e0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+      e1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+    }
+
+    return true;
+  }
+
+  /**
+   * Find the color endpoints of a block.
+   */
+  void _findEndpoints(
+    const _Block &block,
+    const uint8_t min[4], const uint8_t max[4],
+    bool punchThrough,
+    BlockEncoder::Quality quality,
+    float e0[3], float e1[3]
+  )
+  {
+    for (size_t c = 0; c < 3; ++c)
+    {
+      e0[c] = max[c];
+      e1[c] = min[c];
+    }
+
+    if (quality == BlockEncoder::Quality::FAST)
+      return;
+
+    // Principal axis of the opaque texels.
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    size_t count = 0;
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+      if (_isTransparent(block, i, punchThrough))
+        continue;
+
+      for (size_t c = 0; c < 3; ++c)
+        mean[c] += block[i][c];
+
+      ++count;
+    }
+
+    for (size_t c = 0; c < 3; ++c)
+      mean[c] /= count;
+
+    float covariance[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}; // rr rg rb gg gb bb
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+      if (_isTransparent(block, i, punchThrough))
+        continue;
+
+      float r = block[i][0] - mean[0];
+      float g = block[i][1] - mean[1];
+      float b = block[i][2] - mean[2];
+
+      covariance[0] += r * r;
+      covariance[1] += r * g;
+      covariance[2] += r * b;
+      covariance[3] += g * g;
+      covariance[4] += g * b;
+      covariance[5] += b * b;
+    }
+
+    float axis[3] = {
+      static_cast<float>(max[0] - min[0]),
+      static_cast<float>(max[1] - min[1]),
+      static_cast<float>(max[2] - min[2])
+    };
+
+    for (size_t iteration = 0; iteration < 4; ++iteration)
+    {
+      float r = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+      float g = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+      float b = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+
+      float norm = std::max(std::fabs(r), std::max(std::fabs(g), std::fabs(b)));
+
+      if (norm < 1e-6f)
+        return;
+
+      axis[0] = r / norm;
+      axis[1] = g / norm;
+      axis[2] = b / norm;
+    }
+
+    // Extremes along the axis, scaled to the kernel weights range.
+    int16_t weights[4] = {
+      static_cast<int16_t>(std::lround(axis[0] * 255.0f)),
+      static_cast<int16_t>(std::lround(axis[1] * 255.0f)),
+      static_cast<int16_t>(std::lround(axis[2] * 255.0f)),
+      0
+    };
+
+    int32_t dots[16];
+    _project(block, weights, dots);
+
+    size_t first = 16, last = 16;
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+      if (_isTransparent(block, i, punchThrough))
+        continue;
+
+      if (first == 16 || dots[i] > dots[first])
+        first = i;
+
+      if (last == 16 || dots[i] < dots[last])
+        last = i;
+    }
+
+    // Inset by 1/16 of the range, the extremes are rarely hit exactly.
+    for (size_t c = 0; c < 3; ++c)
+    {
+      float inset = (block[first][c] - block[last][c]) / 16.0f;
+      e0[c] = block[first][c] - inset;
+      e1[c] = block[last][c] + inset;
+    }
+  }
+
+  /**
+   * Encode the color block of BC1 and BC3.
+   *
+   * @param punchThrough true to allow the BC1 transparent texels.
+   */
+  void _encodeColor(
+    const _Block &block,
+    bool punchThrough,
+    BlockEncoder::Quality quality,
+    uint8_t *out
+  )
+  {
+    uint8_t min[4], max[4];
+    _minMax(block, min, max);
+
+    punchThrough = punchThrough && min[3] < 128;
+
+    uint16_t c0 = 0, c1 = 0;
+    uint8_t indices[16];
+
+    if (punchThrough && max[3] < 128)
+    {
+      // Fully transparent.
+      std::fill(indices, indices + 16, 3);
+    }
+    else
+    {
+      float e0[3], e1[3];
+      _findEndpoints(block, min, max, punchThrough, quality, e0, e1);
+
+      c0 = _to565(e0);
+      c1 = _to565(e1);
+      int error = _selectColorIndices(block, c0, c1, punchThrough, indices);
+
+      size_t iterations = (quality == BlockEncoder::Quality::HIGH) ? 2 : 0;
+
+      for (size_t iteration = 0; iteration < iterations && error > 0; ++iteration)
+      {
+        if (!_refineEndpoints(block, indices, punchThrough, e0, e1))
+          break;
+
+        uint16_t r0 = _to565(e0);
+        uint16_t r1 = _to565(e1);
+        uint8_t refined[16];
+        int refinedError = _selectColorIndices(block, r0, r1, punchThrough, refined);
+
+        if (refinedError >= error)
+          break;
+
+        c0 = r0;
+        c1 = r1;
+        error = refinedError;
+        std::copy(refined, refined + 16, indices);
+      }
+
+      // The mode is given by the endpoints order.
+      bool swap = punchThrough ? (c0 > c1) : (c0 < c1);
+
+      if (swap)
+      {
+        std::swap(c0, c1);
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+          if (!punchThrough || indices[i] < 2)
+            indices[i] ^= 1;
+        }
+      }
+      else if (!punchThrough && c0 == c1)
+      {
+        std::fill(indices, indices + 16, 0);
+      }
+    }
+
+    uint32_t packed = 0;
+    for (size_t i = 0; i < 16; ++i)
+      packed |= static_cast<uint32_t>(indices[i]) << (2 * i);
+
+    out[0] = c0 & 0xFF;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF;
+    out[3] = c1 >> 8;
+
+    for (size_t i = 0; i < 4; ++i)
+      out[4 + i] = (packed >> (8 * i)) & 0xFF;
+  }
+
+  //-----------------------//
+  // Single channel blocks //
+  //-----------------------//
+
+  /**
+   * Encode one channel as a BC3 alpha or BC4 block, 8 interpolated values
+   * between the channel extremes.
+   */
+  void _encodeChannel(const _Block &block, size_t channel, uint8_t min, uint8_t max, uint8_t *out)
+  {
+    uint64_t packed = 0;
+
+    if (max > min)
+    {
+      int range = max - min;
+
+      for (size_t i = 0; i < 16; ++i)
+      {
+        // Position from min (index 1) to max (index 0).
+        int step = ((block[i][channel] - min) * 14 + range) / (2 * range);
+        uint64_t index = (step == 7) ? 0 : (step == 0) ? 1 : 8 - step;
+
+        packed |= index << (3 * i);
+      }
+    }
+
+    out[0] = max;
+    out[1] = min;
+
+    for (size_t i = 0; i < 6; ++i)
+      out[2 + i] = (packed >> (8 * i)) & 0xFF;
+  }
+
+  void _encodeBlock(
+    const _Block &block,
+    BlockEncoder::Format format,
+    BlockEncoder::Quality quality,
+    uint8_t *out
+  )
+  {
+    uint8_t min[4], max[4];
+
+    switch (format)
+    {
+      case BlockEncoder::Format::BC1:
+        _encodeColor(block, true, quality, out);
+        break;
+
+      case BlockEncoder::Format::BC3:
+        _minMax(block, min, max);
+        _encodeChannel(block, 3, min[3], max[3], out);
+        _encodeColor(block, false, quality, out + 8);
+        break;
+
+      case BlockEncoder::Format::BC4:
+        _minMax(block, min, max);
+        _encodeChannel(block, 0, min[0], max[0], out);
+        break;
+
+      case BlockEncoder::Format::BC5:
+        _minMax(block, min, max);
+        _encodeChannel(block, 0, min[0], max[0], out);
+        _encodeChannel(block, 1, min[1], max[1], out + 8);
+        break;
+    }
+  }
+}
+
+//--------------//
+// BlockEncoder //
+//--------------//
+
+GLenum BlockEncoder::getInternalFormat(Format format, bool srgb)
+{
+  switch (format)
+  {
+    case Format::BC1:
+      return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+
+    case Format::BC3:
+      return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+    case Format::BC4:
+      return GL_COMPRESSED_RED_RGTC1;
+
+    case Format::BC5:
+      return GL_COMPRESSED_RG_RGTC2;
+  }
+
+  return GL_NONE;
+}
+
+size_t BlockEncoder::getBlockSize(Format format)
+{
+  return (format == Format::BC1 || format == Format::BC4) ? 8 : 16;
+}
+
+size_t BlockEncoder::getEncodedSize(Format format, size_t width, size_t height)
+{
+  return ((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+}
+
+BlockEncoder::BlockEncoder(Format format, Quality quality, ThreadPool *pool)
+: m_format(format), m_quality(quality), m_pool(pool ? pool : &ThreadPool::getGlobal())
+{
+
+}
+
+void BlockEncoder::encode(
+  const unsigned char *pixels,
+  size_t width, size_t height,
+  size_t rowLength,
+  unsigned char *blocks
+) const
+{
+  assert(width > 0 && height > 0);
+
+  if (rowLength == 0)
+    rowLength = width;
+
+  size_t blocksX = (width + 3) / 4;
+  size_t blocksY = (height + 3) / 4;
+  size_t blockSize = getBlockSize(m_format);
+
+  // One range per row of blocks.
+  m_pool->run(blocksY, [&](size_t first, size_t last) {
+    _Block block;
+
+    for (size_t blockY = first; blockY < last; ++blockY)
+    {
+      for (size_t blockX = 0; blockX < blocksX; ++blockX)
+      {
+        _loadBlock(pixels, width, height, rowLength, blockX, blockY, block);
+        _encodeBlock(block, m_format, m_quality, blocks + (blockY * blocksX + blockX) * blockSize);
+      }
+    }
+  });
+}
+
+std::vector<unsigned char> BlockEncoder::encode(
+  const unsigned char *pixels,
+  size_t width, size_t height
+) const
+{
+  std::vector<unsigned char> blocks(getEncodedSize(m_format, width, height));
+  encode(pixels, width, height, 0, blocks.data());
+  return blocks;
+}
+
+void BlockEncoder::upload(
+  Texture &texture,
+  size_t level,
+  const unsigned char *pixels,
+  size_t width, size_t height,
+  bool srgb
+) const
+{
+  std::vector<unsigned char> blocks = encode(pixels, width, height);
+
+  texture.setCompressedData(
+    level,
+    getInternalFormat(m_format, srgb),
+    width, height,
+    blocks.size(),
+    blocks.data()
+  );
+}
@@ -1,97 +1,228 @@
 #include <cstdlib>
 #include <cassert>
 #include <iostream>
+#include <algorithm>
+#include <map>
 
 #include <glbinding/Meta.h>
+#include <glbinding/ContextInfo.h>
+#include <glbinding/Version.h>
+#include <glbinding/ContextHandle.h>
 
 #include <TacoGL/Error.h>
 
+#include <TacoGL/ExtensionRegister.h>
+#include <TacoGL/MemoryRegistry.h>
 #include <TacoGL/Buffer.h>
+#include <TacoGL/Shader.h>
+#include <TacoGL/Program.h>
 
 using namespace gl;
 using namespace glbinding;
 using namespace TacoGL;
 
-BufferManager::BufferManager()
+namespace
 {
-
+  const size_t FILL_WORKGROUP_SIZE = 256;
+  const size_t FILL_MAX_WORKGROUPS = 65535;
+  const size_t FILL_STAGING_SIZE = 64 * 1024;
+
+  const char *FILL_SOURCE =
+    "#version 420 core\n"
+    "#extension GL_ARB_compute_shader : require\n"
+    "#extension GL_ARB_shader_storage_buffer_object : require\n"
+    "layout(local_size_x = 256) in;\n"
+    "layout(std430, binding = 0) buffer Data { uint words[]; };\n"
+    "uniform uvec4 pattern;\n"
+    "uniform uint patternSize;\n"
+    "uniform uint first;\n"
+    "uniform uint count;\n"
+    "void main()\n"
+    "{\n"
+    "  uint index = gl_WorkGroupID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x\n"
+    "    + gl_GlobalInvocationID.x;\n"
+    "  if (index >= count) return;\n"
+    "  words[first + index] = pattern[index % patternSize];\n"
+    "}\n";
+
+  /**
+   * Barrier over the operations sourcing buffers, the later uses of a
+   * filled buffer.
+   */
+  const MemoryBarrierMask FILL_BARRIERS =
+    GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+    GL_ELEMENT_ARRAY_BARRIER_BIT |
+    GL_UNIFORM_BARRIER_BIT |
+    GL_TEXTURE_FETCH_BARRIER_BIT |
+    GL_COMMAND_BARRIER_BIT |
+    GL_PIXEL_BUFFER_BARRIER_BIT |
+    GL_BUFFER_UPDATE_BARRIER_BIT |
+    GL_TRANSFORM_FEEDBACK_BARRIER_BIT |
+    GL_ATOMIC_COUNTER_BARRIER_BIT |
+    GL_SHADER_STORAGE_BARRIER_BIT;
+
+  /**
+   * Fill programs per context, programs are not shared between contexts.
+   */
+  std::map<ContextHandle, Program*> _fillPrograms;
+
+  /**
+   * Retrieve the fill program of the current context, built at first use.
+   */
+  Program & _getFillProgram()
+  {
+    Program *&program = _fillPrograms[getCurrentContext()];
+
+    if (!program)
+    {
+      Shader shader(GL_COMPUTE_SHADER);
+      shader.setSource(GLSLSource{FILL_SOURCE});
+      shader.compile();
+
+      program = new Program();
+      program->attach(shader);
+      program->link();
+      program->detach(shader);
+    }
+
+    return *program;
+  }
 }
 
-BufferManager::~BufferManager()
+const size_t BufferManager::TARGET_COUNT;
+const size_t BufferManager::INVALID_SLOT;
+
+size_t BufferManager::getSlot(GLenum target)
 {
+  switch (target)
+  {
+    case GL_ARRAY_BUFFER: return 0;
+    case GL_ATOMIC_COUNTER_BUFFER: return 1;
+    case GL_COPY_READ_BUFFER: return 2;
+    case GL_COPY_WRITE_BUFFER: return 3;
+    case GL_DRAW_INDIRECT_BUFFER: return 4;
+    case GL_DISPATCH_INDIRECT_BUFFER: return 5;
+    case GL_ELEMENT_ARRAY_BUFFER: return 6;
+    case GL_PIXEL_PACK_BUFFER: return 7;
+    case GL_PIXEL_UNPACK_BUFFER: return 8;
+    case GL_SHADER_STORAGE_BUFFER: return 9;
+    case GL_TRANSFORM_FEEDBACK_BUFFER: return 10;
+    case GL_UNIFORM_BUFFER: return 11;
+    default: return INVALID_SLOT;
+  }
+}
 
+GLenum BufferManager::getSlotTarget(size_t slot)
+{
+  static const GLenum targets[TARGET_COUNT] = {
+    GL_ARRAY_BUFFER,
+    GL_ATOMIC_COUNTER_BUFFER,
+    GL_COPY_READ_BUFFER,
+    GL_COPY_WRITE_BUFFER,
+    GL_DRAW_INDIRECT_BUFFER,
+    GL_DISPATCH_INDIRECT_BUFFER,
+    GL_ELEMENT_ARRAY_BUFFER,
+    GL_PIXEL_PACK_BUFFER,
+    GL_PIXEL_UNPACK_BUFFER,
+    GL_SHADER_STORAGE_BUFFER,
+    GL_TRANSFORM_FEEDBACK_BUFFER,
+    GL_UNIFORM_BUFFER
+  };
+
+  assert(slot < TARGET_COUNT);
+  return targets[slot];
 }
 
-const BufferManager::BindedTargetMap &
-BufferManager::getTarget() const
+BufferManager::BufferManager()
 {
-  return m_target;
+  m_binding.fill(0);
 }
 
-const BufferManager::BindingMap &
-BufferManager::getBinding() const
+BufferManager::~BufferManager()
 {
-  return m_binding;
+
 }
 
-bool BufferManager::isAvaible(gl::GLenum target) const
+bool BufferManager::isAvaible(GLenum target) const
 {
-  return m_target.find(target) == m_target.end();
+  size_t slot = getSlot(target);
+  assert(slot != INVALID_SLOT);
+
+  if (slot == INVALID_SLOT)
+    return false;
+
+  return m_binding[slot] == 0;
 }
 
 bool BufferManager::isBinded(GLuint bufferId) const
 {
-  return m_binding.find(bufferId) != m_binding.end();
+  return std::find(m_binding.begin(), m_binding.end(), bufferId) != m_binding.end();
 }
 
-// bool isBinded(gl::GLuint bufferId, gl::GLenum target) const
-// {
-//   if (!isBinded(bufferId))
-//     return false;
-
-//   return m_binding.at(bufferId) == target;
-// }
-
 GLenum BufferManager::getBinding(GLuint bufferId) const
 {
-  // assert(isBinded(bufferId));
-  return m_binding.at(bufferId);
+  assert(isBinded(bufferId));
+
+  size_t slot = std::find(m_binding.begin(), m_binding.end(), bufferId) - m_binding.begin();
+  return getSlotTarget(slot);
 }
 
 void BufferManager::bind(GLenum target, GLuint bufferId)
 {
-  // assert(isAvaible(target));
+  size_t slot = getSlot(target);
+  assert(slot != INVALID_SLOT);
+
+  if (m_binding[slot] == bufferId)
+    return;
 
   glBindBuffer(target, bufferId);
 
-  m_target.insert(target);
-  m_binding.emplace(bufferId, target);
+  m_binding[slot] = bufferId;
 }
 
 void BufferManager::unbind(GLuint bufferId)
 {
-  // assert(isBinded(bufferId));
-
-  GLenum target = m_binding.at(bufferId);
+  for (size_t slot = 0; slot < TARGET_COUNT; ++slot)
+  {
+    if (m_binding[slot] == bufferId)
+    {
+      glBindBuffer(getSlotTarget(slot), 0);
+      m_binding[slot] = 0;
+    }
+  }
+}
 
-  glBindBuffer(target, 0);
+void BufferManager::record(GLenum target, GLuint bufferId)
+{
+  size_t slot = getSlot(target);
+  assert(slot != INVALID_SLOT);
 
-  m_target.erase(target);
-  m_binding.erase(bufferId);
+  m_binding[slot] = bufferId;
 }
 
-void BufferManager::debug() const
+void BufferManager::reset(GLenum target)
 {
-  std::cout << "DEBUG: buffer target map" << std::endl;
+  size_t slot = getSlot(target);
+  assert(slot != INVALID_SLOT);
 
-  for (auto &target : m_target) {
-    std::cout << "Target " << Meta::getString(target) << std::endl;
-  }
+  m_binding[slot] = 0;
+}
 
-  std::cout << "DEBUG: buffer binding map" << std::endl;
+void BufferManager::release(GLuint bufferId)
+{
+  std::replace(m_binding.begin(), m_binding.end(), bufferId, 0u);
+}
 
-  for (auto &item : m_binding) {
-    std::cout << "Buffer " << item.first << " binded to " << Meta::getString(item.second) << std::endl;
+void BufferManager::debug() const
+{
+  std::cout << "DEBUG: buffer binding table" << std::endl;
+
+  for (size_t slot = 0; slot < TARGET_COUNT; ++slot)
+  {
+    if (m_binding[slot])
+    {
+      std::cout << "Buffer " << m_binding[slot] << " binded to " << Meta::getString(getSlotTarget(slot)) << std::endl;
+    }
   }
 }
 
@@ -172,15 +303,86 @@ gl::GLuint Buffer::getBinding<gl::GL_UNIFORM_BUFFER>()
 }
 
 BufferManager Buffer::s_manager;
+Buffer::DirectStateAccess Buffer::s_directStateAccess = Buffer::DirectStateAccess::UNKNOWN;
+
+bool Buffer::hasDirectStateAccess()
+{
+  return ContextInfo::version() >= Version(4, 5)
+    || ExtensionRegister::isAvaible(GLextension::GL_ARB_direct_state_access);
+}
+
+bool Buffer::hasClearBuffer()
+{
+  static const bool clearBuffer = ContextInfo::version() >= Version(4, 3)
+    || ExtensionRegister::isAvaible(GLextension::GL_ARB_clear_buffer_object);
+
+  return clearBuffer;
+}
+
+void Buffer::releaseFillProgram()
+{
+  auto program = _fillPrograms.find(getCurrentContext());
+
+  if (program == _fillPrograms.end())
+    return;
+
+  delete program->second;
+  _fillPrograms.erase(program);
+}
+
+bool Buffer::hasInvalidate()
+{
+  static const bool invalidate = ContextInfo::version() >= Version(4, 3)
+    || ExtensionRegister::isAvaible(GLextension::GL_ARB_invalidate_subdata);
+
+  return invalidate;
+}
+
+bool Buffer::hasComputeFill()
+{
+  static const bool computeFill = ContextInfo::version() >= Version(4, 3) || (
+    ExtensionRegister::isAvaible(GLextension::GL_ARB_compute_shader) &&
+    ExtensionRegister::isAvaible(GLextension::GL_ARB_shader_storage_buffer_object)
+  );
+
+  return computeFill;
+}
+
+bool Buffer::isDirectStateAccessEnabled()
+{
+  if (s_directStateAccess == DirectStateAccess::UNKNOWN)
+  {
+    setDirectStateAccess(true);
+  }
+
+  return s_directStateAccess == DirectStateAccess::ENABLED;
+}
+
+void Buffer::setDirectStateAccess(bool enabled)
+{
+  s_directStateAccess = (enabled && hasDirectStateAccess())
+    ? DirectStateAccess::ENABLED
+    : DirectStateAccess::DISABLED;
+}
 
 Buffer::Buffer()
-: m_size(0)
+: m_size(0),
+  m_usage(GL_STATIC_DRAW),
+  m_immutable(false),
+  m_orphaning(false),
+  m_slot(BufferManager::INVALID_SLOT)
 {
-  glGenBuffers(1, &m_id);
+  if (isDirectStateAccessEnabled())
+    glCreateBuffers(1, &m_id);
+  else
+    glGenBuffers(1, &m_id);
 }
 
 Buffer::~Buffer()
 {
+  // OpenGL unbinds deleted buffers, the id may be reused.
+  s_manager.release(m_id);
+  MemoryRegistry::remove(this);
   glDeleteBuffers(1, &m_id);
 }
 
@@ -189,23 +391,295 @@ size_t Buffer::getSize() const
   return m_size;
 }
 
+void Buffer::resetBinding(gl::GLenum target)
+{
+  s_manager.reset(target);
+}
+
+void Buffer::recordBinding(gl::GLenum target, gl::GLuint bufferId)
+{
+  s_manager.record(target, bufferId);
+}
+
 bool Buffer::isBinded() const
 {
-  return s_manager.isBinded(m_id);
+  return m_slot != BufferManager::INVALID_SLOT && s_manager.isBinded(m_id, m_slot);
 }
 
 gl::GLenum Buffer::getTarget() const
 {
-  // assert(isBinded());
-  return s_manager.getBinding(m_id);
+  assert(isBinded());
+  return BufferManager::getSlotTarget(m_slot);
 }
 
 void Buffer::bind(gl::GLenum target)
 {
+  size_t slot = BufferManager::getSlot(target);
+
+  // A buffer is binded to one target at a time.
+  if (isBinded() && m_slot != slot)
+    unbind();
+
   s_manager.bind(target, m_id);
+  m_slot = slot;
 }
 
 void Buffer::unbind()
 {
-  s_manager.unbind(m_id);
+  if (isBinded())
+    s_manager.unbind(m_id);
+
+  m_slot = BufferManager::INVALID_SLOT;
+}
+
+void Buffer::bindBase(GLenum target, size_t index)
+{
+  glBindBufferBase(target, index, m_id);
+
+  // Also binds the generic binding point.
+  s_manager.record(target, m_id);
+}
+
+void Buffer::bindRange(GLenum target, size_t index, size_t offset, size_t size)
+{
+  glBindBufferRange(target, index, m_id, offset, size);
+
+  // Also binds the generic binding point.
+  s_manager.record(target, m_id);
+}
+
+void Buffer::allocateData(size_t size, GLenum usage, const void *data)
+{
+  m_size = size;
+  m_usage = usage;
+  m_immutable = false;
+
+  MemoryRegistry::update(MemoryRegistry::Category::BUFFER, this, size);
+
+  if (isDirectStateAccessEnabled())
+  {
+    glNamedBufferData(m_id, size, data, usage);
+  }
+  else
+  {
+    assert(isBinded());
+    glBufferData(getTarget(), size, data, usage);
+  }
+}
+
+void Buffer::allocateData(size_t size, MapBufferUsageMask flags, const void *data)
+{
+  m_size = size;
+  m_immutable = true;
+
+  MemoryRegistry::update(MemoryRegistry::Category::BUFFER, this, size);
+
+  if (isDirectStateAccessEnabled())
+  {
+    glNamedBufferStorage(m_id, size, data, flags);
+  }
+  else
+  {
+    assert(isBinded());
+    glBufferStorage(getTarget(), size, data, flags);
+  }
+}
+
+void Buffer::setData(size_t offset, size_t size, const void *data)
+{
+  if (m_orphaning && offset == 0 && size == m_size)
+  {
+    if (!m_immutable)
+    {
+      // Re-specify the storage and upload in one call.
+      allocateData(size, m_usage, data);
+      return;
+    }
+
+    invalidate();
+  }
+
+  if (isDirectStateAccessEnabled())
+  {
+    glNamedBufferSubData(m_id, offset, size, data);
+  }
+  else
+  {
+    assert(isBinded());
+    glBufferSubData(getTarget(), offset, size, data);
+  }
+}
+
+void Buffer::getData(size_t offset, size_t size, void *data) const
+{
+  if (isDirectStateAccessEnabled())
+  {
+    glGetNamedBufferSubData(m_id, offset, size, data);
+  }
+  else
+  {
+    assert(isBinded());
+    glGetBufferSubData(getTarget(), offset, size, data);
+  }
+}
+
+void Buffer::copy(const Buffer &source, size_t readOffset, size_t writeOffset, size_t size)
+{
+  if (isDirectStateAccessEnabled())
+  {
+    glCopyNamedBufferSubData(source.getId(), m_id, readOffset, writeOffset, size);
+  }
+  else
+  {
+    assert(isBinded());
+    assert(source.isBinded());
+    glCopyBufferSubData(source.getTarget(), getTarget(), readOffset, writeOffset, size);
+  }
+}
+
+void Buffer::invalidate()
+{
+  if (hasInvalidate())
+    glInvalidateBufferData(m_id);
+}
+
+void Buffer::invalidateRange(size_t offset, size_t size)
+{
+  if (hasInvalidate())
+    glInvalidateBufferSubData(m_id, offset, size);
+}
+
+void Buffer::clearData(
+  GLenum internalFormat,
+  GLenum format,
+  GLenum type,
+  size_t offset,
+  size_t size,
+  const void *data
+)
+{
+  assert(offset + size <= m_size);
+
+  if (isDirectStateAccessEnabled())
+  {
+    glClearNamedBufferSubData(m_id, internalFormat, offset, size, format, type, data);
+  }
+  else
+  {
+    assert(isBinded());
+    glClearBufferSubData(getTarget(), internalFormat, offset, size, format, type, data);
+  }
+}
+
+void Buffer::fillData(size_t offset, size_t size, const void *pattern, size_t patternSize)
+{
+  assert(patternSize > 0 && size % patternSize == 0);
+  assert(offset + size <= m_size);
+
+  if (size == 0)
+    return;
+
+  const unsigned char *bytes = static_cast<const unsigned char*>(pattern);
+
+  if (
+    hasComputeFill() &&
+    patternSize % 4 == 0 && patternSize <= 16 &&
+    offset % 4 == 0
+  )
+  {
+    GLuint words[4] = {0, 0, 0, 0};
+    std::copy_n(bytes, patternSize, reinterpret_cast<unsigned char*>(words));
+
+    size_t count = size / 4;
+    size_t groups = (count + FILL_WORKGROUP_SIZE - 1) / FILL_WORKGROUP_SIZE;
+    size_t groupsX = std::min(groups, FILL_MAX_WORKGROUPS);
+    size_t groupsY = (groups + groupsX - 1) / groupsX;
+
+    // Caller state, restored after the dispatch.
+    GLint previousProgram = TacoGL::get<GL_CURRENT_PROGRAM, GLint>();
+    GLint previousGeneric = TacoGL::get<GL_SHADER_STORAGE_BUFFER_BINDING, GLint>();
+    GLint previousBuffer = 0;
+    GLint64 previousStart = 0;
+    GLint64 previousSize = 0;
+
+    glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, 0, &previousBuffer);
+    glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_START, 0, &previousStart);
+    glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_SIZE, 0, &previousSize);
+
+    Program &program = _getFillProgram();
+    program.use();
+
+    glProgramUniform4uiv(program.getId(), program.getUniformLocation("pattern"), 1, words);
+    program.setUniform("patternSize", static_cast<GLuint>(patternSize / 4));
+    program.setUniform("first", static_cast<GLuint>(offset / 4));
+    program.setUniform("count", static_cast<GLuint>(count));
+
+    // Not recorded by the manager, the bindings are restored below.
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_id);
+    glDispatchCompute(groupsX, groupsY, 1);
+    glMemoryBarrier(FILL_BARRIERS);
+
+    if (previousSize > 0)
+      glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, previousBuffer, previousStart, previousSize);
+    else
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, previousBuffer);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, previousGeneric);
+    glUseProgram(previousProgram);
+  }
+  else
+  {
+    // Upload by chunks, host memory stays bounded.
+    size_t chunk = std::max(FILL_STAGING_SIZE / patternSize, size_t(1)) * patternSize;
+    std::vector<unsigned char> staging(std::min(chunk, size));
+
+    for (size_t i = 0; i < staging.size(); i += patternSize)
+    {
+      std::copy_n(bytes, patternSize, staging.begin() + i);
+    }
+
+    for (size_t done = 0; done < size; done += staging.size())
+    {
+      setData(offset + done, std::min(staging.size(), size - done), staging.data());
+    }
+  }
+}
+
+void* Buffer::mapData(size_t offset, size_t size, BufferAccessMask access)
+{
+  if (isDirectStateAccessEnabled())
+  {
+    return glMapNamedBufferRange(m_id, offset, size, access);
+  }
+  else
+  {
+    assert(isBinded());
+    return glMapBufferRange(getTarget(), offset, size, access);
+  }
+}
+
+void Buffer::flushData(size_t offset, size_t size)
+{
+  if (isDirectStateAccessEnabled())
+  {
+    glFlushMappedNamedBufferRange(m_id, offset, size);
+  }
+  else
+  {
+    assert(isBinded());
+    glFlushMappedBufferRange(getTarget(), offset, size);
+  }
+}
+
+bool Buffer::unmap()
+{
+  if (isDirectStateAccessEnabled())
+  {
+    return glUnmapNamedBuffer(m_id) == GL_TRUE;
+  }
+  else
+  {
+    assert(isBinded());
+    return glUnmapBuffer(getTarget()) == GL_TRUE;
+  }
 }
@@ -0,0 +1,111 @@
+#include <cassert>
+#include <algorithm>
+
+#include <TacoGL/BufferAllocator.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+BufferAllocator::BufferAllocator(size_t pageSize, GLenum usage, size_t alignment)
+: m_pages(), m_pageSize(pageSize), m_usage(usage), m_alignment(alignment)
+{
+  assert(alignment > 0);
+  assert(pageSize % alignment == 0);
+}
+
+BufferAllocator::~BufferAllocator()
+{
+  for (Page *page : m_pages)
+  {
+    delete page->buffer;
+    delete page;
+  }
+}
+
+BufferAllocator::Allocation BufferAllocator::allocate(size_t size)
+{
+  // The page allocators count in alignment units.
+  size_t units = (size + m_alignment - 1) / m_alignment;
+
+  for (size_t i = 0; i < m_pages.size(); ++i)
+  {
+    OffsetAllocator::Allocation range = m_pages[i]->allocator.allocate(units);
+
+    if (range.isValid())
+    {
+      return Allocation{
+        m_pages[i]->buffer,
+        range.offset * m_alignment,
+        size,
+        i,
+        range
+      };
+    }
+  }
+
+  size_t pageUnits = m_pageSize / m_alignment;
+  Page *page = createPage(std::max(units, pageUnits) * m_alignment);
+
+  OffsetAllocator::Allocation range = page->allocator.allocate(units);
+  assert(range.isValid());
+
+  return Allocation{
+    page->buffer,
+    range.offset * m_alignment,
+    size,
+    m_pages.size() - 1,
+    range
+  };
+}
+
+void BufferAllocator::free(const Allocation &allocation)
+{
+  assert(allocation.isValid());
+  assert(allocation.page < m_pages.size());
+
+  m_pages[allocation.page]->allocator.free(allocation.range);
+}
+
+BufferAllocator::Statistics BufferAllocator::getStatistics() const
+{
+  Statistics statistics = Statistics{m_pages.size(), 0, 0, 0, 0, 0, 0};
+
+  for (const Page *page : m_pages)
+  {
+    OffsetAllocator::Statistics pageStatistics = page->allocator.getStatistics();
+
+    statistics.size += pageStatistics.size * m_alignment;
+    statistics.freeSize += pageStatistics.freeSize * m_alignment;
+    statistics.largestFreeRegion = std::max(
+      statistics.largestFreeRegion,
+      pageStatistics.largestFreeRegion * m_alignment
+    );
+    statistics.freeRegionCount += pageStatistics.freeRegionCount;
+    statistics.allocationCount += pageStatistics.allocationCount;
+  }
+
+  statistics.usedSize = statistics.size - statistics.freeSize;
+
+  return statistics;
+}
+
+BufferAllocator::Page * BufferAllocator::createPage(size_t size)
+{
+  Buffer *buffer = new Buffer();
+
+  if (Buffer::isDirectStateAccessEnabled())
+  {
+    buffer->allocate<unsigned char>(size, m_usage);
+  }
+  else
+  {
+    buffer->bind(GL_COPY_WRITE_BUFFER);
+    buffer->allocate<unsigned char>(size, m_usage);
+    buffer->unbind();
+  }
+
+  Page *page = new Page{buffer, OffsetAllocator(size / m_alignment)};
+  m_pages.push_back(page);
+
+  return page;
+}
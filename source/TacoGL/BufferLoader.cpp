@@ -0,0 +1,174 @@
+#include <cassert>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <TacoGL/BufferLoader.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+const size_t BufferLoader::PREFETCH_DEPTH;
+
+namespace
+{
+  /**
+   * Background thread faulting in the chunks ahead of the upload.
+   */
+  class _Prefetcher
+  {
+  public:
+    _Prefetcher(const MappedFile &file, size_t offset, size_t size, size_t chunkSize)
+    : m_file(file),
+      m_offset(offset),
+      m_size(size),
+      m_chunkSize(chunkSize),
+      m_uploaded(0),
+      m_stopped(false),
+      m_thread(&_Prefetcher::run, this)
+    {
+
+    }
+
+    ~_Prefetcher()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+      }
+
+      m_condition.notify_one();
+      m_thread.join();
+    }
+
+    /**
+     * Notify that the chunks up to chunk are uploaded.
+     */
+    void advance(size_t chunk)
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_uploaded = chunk;
+      }
+
+      m_condition.notify_one();
+    }
+
+  protected:
+    const MappedFile &m_file;
+    size_t m_offset;
+    size_t m_size;
+    size_t m_chunkSize;
+    size_t m_uploaded; ///< the number of chunks uploaded.
+    bool m_stopped;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread; ///< declared last, started once the state is set.
+
+    void run()
+    {
+      for (size_t done = 0, chunk = 0; done < m_size; done += m_chunkSize, ++chunk)
+      {
+        {
+          std::unique_lock<std::mutex> lock(m_mutex);
+          m_condition.wait(lock, [&]() {
+            return m_stopped || chunk <= m_uploaded + BufferLoader::PREFETCH_DEPTH;
+          });
+
+          if (m_stopped)
+            return;
+        }
+
+        size_t size = std::min(m_chunkSize, m_size - done);
+        m_file.prefetch(m_offset + done, size);
+        m_file.touch(m_offset + done, size);
+      }
+    }
+  };
+}
+
+BufferLoader::BufferLoader(size_t chunkSize, bool prefetching)
+: m_chunkSize(0), m_prefetching(prefetching), m_progress()
+{
+  setChunkSize(chunkSize);
+}
+
+void BufferLoader::setChunkSize(size_t chunkSize)
+{
+  assert(chunkSize > 0);
+
+  // Whole pages, chunks of page aligned ranges do not share pages.
+  size_t pageSize = MappedFile::getPageSize();
+  m_chunkSize = std::max((chunkSize + pageSize - 1) / pageSize, size_t(1)) * pageSize;
+}
+
+void BufferLoader::load(const std::string &path, Buffer &buffer, GLenum usage)
+{
+  MappedFile file(path);
+  load(file, buffer, usage);
+}
+
+void BufferLoader::load(const MappedFile &file, Buffer &buffer, GLenum usage)
+{
+  bool binding = !Buffer::isDirectStateAccessEnabled();
+
+  if (binding)
+    buffer.bind(GL_COPY_WRITE_BUFFER);
+
+  buffer.allocateData(file.size(), usage);
+
+  if (binding)
+    buffer.unbind();
+
+  upload(file, 0, file.size(), buffer, 0);
+}
+
+void BufferLoader::upload(
+  const MappedFile &file,
+  size_t fileOffset,
+  size_t size,
+  Buffer &buffer,
+  size_t bufferOffset
+)
+{
+  assert(fileOffset + size <= file.size());
+  assert(bufferOffset + size <= buffer.getSize());
+
+  if (size == 0)
+    return;
+
+  bool binding = !Buffer::isDirectStateAccessEnabled();
+
+  if (binding)
+    buffer.bind(GL_COPY_WRITE_BUFFER);
+
+  {
+    // Joined before unbinding, even when an upload throws.
+    std::unique_ptr<_Prefetcher> prefetcher;
+
+    if (m_prefetching && size > m_chunkSize)
+      prefetcher.reset(new _Prefetcher(file, fileOffset, size, m_chunkSize));
+
+    size_t chunk = 0;
+    for (size_t done = 0; done < size; done += m_chunkSize)
+    {
+      size_t chunkSize = std::min(m_chunkSize, size - done);
+
+      buffer.setData(bufferOffset + done, chunkSize, file.data() + fileOffset + done);
+
+      // glBufferSubData has copied the data, the pages can go.
+      file.release(fileOffset + done, chunkSize);
+
+      if (prefetcher)
+        prefetcher->advance(++chunk);
+
+      if (m_progress)
+        m_progress(done + chunkSize, size);
+    }
+  }
+
+  if (binding)
+    buffer.unbind();
+}
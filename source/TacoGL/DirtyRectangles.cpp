@@ -0,0 +1,128 @@
+#include <cassert>
+#include <algorithm>
+
+#include <TacoGL/DirtyRectangles.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+DirtyRectangles::DirtyRectangles()
+: m_levels(), m_mergeThreshold(1.f)
+{
+
+}
+
+const std::vector<DirtyRectangles::Rectangle> & DirtyRectangles::getRectangles(size_t level) const
+{
+  static const std::vector<Rectangle> empty;
+
+  return (level < m_levels.size()) ? m_levels[level] : empty;
+}
+
+void DirtyRectangles::setMergeThreshold(float threshold)
+{
+  assert(threshold >= 1.f);
+  m_mergeThreshold = threshold;
+}
+
+void DirtyRectangles::add(size_t x, size_t y, size_t width, size_t height, size_t level)
+{
+  if (width == 0 || height == 0)
+    return;
+
+  if (level >= m_levels.size())
+    m_levels.resize(level + 1);
+
+  std::vector<Rectangle> &rectangles = m_levels[level];
+  Rectangle rectangle{x, y, width, height};
+
+  // A merged rectangle may reach other ones, merge until stable.
+  bool merged = true;
+  while (merged)
+  {
+    merged = false;
+
+    for (size_t i = 0; i < rectangles.size(); ++i)
+    {
+      if (merge(rectangle, rectangles[i]))
+      {
+        rectangles[i] = rectangles.back();
+        rectangles.pop_back();
+        merged = true;
+        break;
+      }
+    }
+  }
+
+  rectangles.push_back(rectangle);
+}
+
+bool DirtyRectangles::merge(Rectangle &rectangle, const Rectangle &other) const
+{
+  // Closed intervals, edge to edge rectangles are neighbours.
+  bool touching =
+    rectangle.x <= other.x + other.width && other.x <= rectangle.x + rectangle.width &&
+    rectangle.y <= other.y + other.height && other.y <= rectangle.y + rectangle.height;
+
+  if (!touching)
+    return false;
+
+  size_t left = std::min(rectangle.x, other.x);
+  size_t top = std::min(rectangle.y, other.y);
+  size_t right = std::max(rectangle.x + rectangle.width, other.x + other.width);
+  size_t bottom = std::max(rectangle.y + rectangle.height, other.y + other.height);
+
+  Rectangle bounds{left, top, right - left, bottom - top};
+
+  if (bounds.area() > m_mergeThreshold * (rectangle.area() + other.area()))
+    return false;
+
+  rectangle = bounds;
+  return true;
+}
+
+size_t DirtyRectangles::flush(
+  Texture &texture,
+  GLenum format,
+  GLenum type,
+  const void *image,
+  size_t rowLength,
+  size_t level
+)
+{
+  if (!isDirty(level))
+    return 0;
+
+  std::vector<Rectangle> &rectangles = m_levels[level];
+
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+
+  for (const Rectangle &rectangle : rectangles)
+  {
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, rectangle.x);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, rectangle.y);
+
+    texture.setSubData(
+      level,
+      rectangle.x, rectangle.y,
+      rectangle.width, rectangle.height,
+      format,
+      type,
+      image
+    );
+  }
+
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+  glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+  size_t uploads = rectangles.size();
+  rectangles.clear();
+
+  return uploads;
+}
+
+void DirtyRectangles::clear()
+{
+  m_levels.clear();
+}
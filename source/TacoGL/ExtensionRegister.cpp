@@ -1,6 +1,6 @@
 #include <cassert>
 
-#include <glbinding/Meta.h>
+#include <glbinding/ContextInfo.h>
 
 #include <TacoGL/ExtensionRegister.h>
 
@@ -14,7 +14,7 @@ std::unordered_set<gl::GLextension> & ExtensionRegister::getExtensions()
 {
   if (s_extensions.empty())
   {
-    for (auto extension : Meta::extensions())
+    for (auto extension : ContextInfo::extensions())
     {
       s_extensions.insert(extension);
     }
@@ -25,6 +25,6 @@ std::unordered_set<gl::GLextension> & ExtensionRegister::getExtensions()
 
 bool ExtensionRegister::isAvaible(GLextension ext)
 {
-  auto extensions = getExtensions();
+  auto &extensions = getExtensions();
   return (extensions.find(ext) != extensions.end());
 }
\ No newline at end of file
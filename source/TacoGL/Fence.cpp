@@ -0,0 +1,69 @@
+#include <TacoGL/Fence.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+Fence::Fence() : m_sync(nullptr)
+{
+
+}
+
+Fence::~Fence()
+{
+  reset();
+}
+
+bool Fence::isSet() const
+{
+  return m_sync != nullptr;
+}
+
+bool Fence::isSignaled() const
+{
+  if (!isSet())
+    return true;
+
+  GLint status;
+  glGetSynciv(m_sync, GL_SYNC_STATUS, 1, nullptr, &status);
+
+  return static_cast<GLenum>(status) == GL_SIGNALED;
+}
+
+void Fence::set()
+{
+  reset();
+  m_sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+}
+
+void Fence::reset()
+{
+  if (isSet())
+  {
+    glDeleteSync(m_sync);
+    m_sync = nullptr;
+  }
+}
+
+bool Fence::wait(GLuint64 timeout)
+{
+  if (!isSet())
+    return true;
+
+  GLenum status = glClientWaitSync(m_sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+
+  // Drivers may give up before an infinite timeout, keep waiting.
+  while (status == GL_TIMEOUT_EXPIRED && timeout == GL_TIMEOUT_IGNORED)
+  {
+    status = glClientWaitSync(m_sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+  }
+
+  return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+}
+
+void Fence::waitServer()
+{
+  if (isSet())
+  {
+    glWaitSync(m_sync, GL_NONE_BIT, GL_TIMEOUT_IGNORED);
+  }
+}
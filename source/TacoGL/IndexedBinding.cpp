@@ -0,0 +1,126 @@
+#include <cassert>
+#include <algorithm>
+
+#include <glbinding/ContextInfo.h>
+#include <glbinding/Version.h>
+
+#include <TacoGL/ExtensionRegister.h>
+#include <TacoGL/IndexedBinding.h>
+
+using namespace gl;
+using namespace glbinding;
+using namespace TacoGL;
+
+bool IndexedBindingBatch::hasMultiBind()
+{
+  static const bool multiBind = ContextInfo::version() >= Version(4, 4)
+    || ExtensionRegister::isAvaible(GLextension::GL_ARB_multi_bind);
+
+  return multiBind;
+}
+
+void IndexedBindingBatch::add(GLenum target, size_t index, const Buffer &buffer)
+{
+  add(target, index, buffer, 0, buffer.getSize());
+}
+
+void IndexedBindingBatch::add(GLenum target, size_t index, const Buffer &buffer, size_t offset, size_t size)
+{
+  m_bindings.push_back(Binding{
+    target,
+    static_cast<GLuint>(index),
+    buffer.getId(),
+    static_cast<GLintptr>(offset),
+    static_cast<GLsizeiptr>(size)
+  });
+}
+
+void IndexedBindingBatch::clear()
+{
+  m_bindings.clear();
+}
+
+void IndexedBindingBatch::bind()
+{
+  if (m_bindings.empty())
+    return;
+
+  std::stable_sort(
+    m_bindings.begin(),
+    m_bindings.end(),
+    [](const Binding &a, const Binding &b)
+    {
+      return (a.target != b.target) ? a.target < b.target : a.index < b.index;
+    }
+  );
+
+  // Keep the last binding added for each index.
+  auto same = [](const Binding &a, const Binding &b)
+  {
+    return a.target == b.target && a.index == b.index;
+  };
+  std::reverse(m_bindings.begin(), m_bindings.end());
+  m_bindings.erase(std::unique(m_bindings.begin(), m_bindings.end(), same), m_bindings.end());
+  std::reverse(m_bindings.begin(), m_bindings.end());
+
+  if (hasMultiBind())
+  {
+    size_t first = 0;
+    while (first < m_bindings.size())
+    {
+      size_t last = first + 1;
+      while (
+        last < m_bindings.size() &&
+        m_bindings[last].target == m_bindings[first].target &&
+        m_bindings[last].index == m_bindings[last - 1].index + 1
+      )
+      {
+        ++last;
+      }
+
+      m_buffers.clear();
+      m_offsets.clear();
+      m_sizes.clear();
+      for (size_t i = first; i < last; ++i)
+      {
+        m_buffers.push_back(m_bindings[i].buffer);
+        m_offsets.push_back(m_bindings[i].offset);
+        m_sizes.push_back(m_bindings[i].size);
+      }
+
+      // Does not change the generic binding points.
+      glBindBuffersRange(
+        m_bindings[first].target,
+        m_bindings[first].index,
+        static_cast<GLsizei>(last - first),
+        m_buffers.data(),
+        m_offsets.data(),
+        m_sizes.data()
+      );
+
+      first = last;
+    }
+  }
+  else
+  {
+    for (const Binding &binding : m_bindings)
+    {
+      glBindBufferRange(
+        binding.target,
+        binding.index,
+        binding.buffer,
+        binding.offset,
+        binding.size
+      );
+    }
+
+    // glBindBufferRange also binds the generic binding points.
+    for (size_t i = 0; i < m_bindings.size(); ++i)
+    {
+      if (i + 1 == m_bindings.size() || m_bindings[i + 1].target != m_bindings[i].target)
+      {
+        Buffer::recordBinding(m_bindings[i].target, m_bindings[i].buffer);
+      }
+    }
+  }
+}
@@ -0,0 +1,293 @@
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+
+#include <TacoGL/format.h>
+#include <TacoGL/KtxLoader.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+namespace
+{
+  const unsigned char _IDENTIFIER[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+  };
+
+  const size_t _HEADER_SIZE = 80; ///< identifier, header and index.
+  const size_t _LEVEL_INDEX_SIZE = 24; ///< byteOffset, byteLength, uncompressedByteLength.
+
+  /**
+   * Read a little endian value of the header.
+   */
+  template <typename T>
+  T _read(const MappedFile &file, size_t offset)
+  {
+    assert(offset + sizeof(T) <= file.size());
+
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+      value |= static_cast<T>(file.data()[offset + i]) << (8 * i);
+
+    return value;
+  }
+
+  /**
+   * Range of a level in the file.
+   */
+  struct _Level
+  {
+    size_t offset;
+    size_t size;
+  };
+
+  _Level _getLevel(const MappedFile &file, size_t level)
+  {
+    size_t index = _HEADER_SIZE + level * _LEVEL_INDEX_SIZE;
+
+    uint64_t offset = _read<uint64_t>(file, index);
+    uint64_t size = _read<uint64_t>(file, index + 8);
+
+    if (offset > file.size() || size > file.size() - offset)
+      throw KtxLoader::FormatError(file.getPath(), "level data out of the file");
+
+    return _Level{static_cast<size_t>(offset), static_cast<size_t>(size)};
+  }
+}
+
+//-------------//
+// FormatError //
+//-------------//
+
+KtxLoader::FormatError::FormatError(const std::string &path, const std::string &reason) throw()
+: m_message(path + ": " + reason)
+{
+
+}
+
+KtxLoader::FormatError::~FormatError() throw()
+{
+
+}
+
+const char * KtxLoader::FormatError::what() const throw()
+{
+  return m_message.c_str();
+}
+
+//-----------//
+// KtxLoader //
+//-----------//
+
+GLenum KtxLoader::getInternalFormat(unsigned int vkFormat)
+{
+  switch (vkFormat)
+  {
+    case 131: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;        // BC1_RGB_UNORM
+    case 132: return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;       // BC1_RGB_SRGB
+    case 133: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;       // BC1_RGBA_UNORM
+    case 134: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT; // BC1_RGBA_SRGB
+    case 135: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;       // BC2_UNORM
+    case 136: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT; // BC2_SRGB
+    case 137: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;       // BC3_UNORM
+    case 138: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT; // BC3_SRGB
+    case 139: return GL_COMPRESSED_RED_RGTC1;                // BC4_UNORM
+    case 140: return GL_COMPRESSED_SIGNED_RED_RGTC1;         // BC4_SNORM
+    case 141: return GL_COMPRESSED_RG_RGTC2;                 // BC5_UNORM
+    case 142: return GL_COMPRESSED_SIGNED_RG_RGTC2;          // BC5_SNORM
+    case 143: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;  // BC6H_UFLOAT
+    case 144: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;    // BC6H_SFLOAT
+    case 145: return GL_COMPRESSED_RGBA_BPTC_UNORM;          // BC7_UNORM
+    case 146: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;    // BC7_SRGB
+    case 147: return GL_COMPRESSED_RGB8_ETC2;                // ETC2_R8G8B8_UNORM
+    case 148: return GL_COMPRESSED_SRGB8_ETC2;               // ETC2_R8G8B8_SRGB
+    case 149: return GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+    case 150: return GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+    case 151: return GL_COMPRESSED_RGBA8_ETC2_EAC;           // ETC2_R8G8B8A8_UNORM
+    case 152: return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;    // ETC2_R8G8B8A8_SRGB
+    case 153: return GL_COMPRESSED_R11_EAC;                  // EAC_R11_UNORM
+    case 154: return GL_COMPRESSED_SIGNED_R11_EAC;           // EAC_R11_SNORM
+    case 155: return GL_COMPRESSED_RG11_EAC;                 // EAC_R11G11_UNORM
+    case 156: return GL_COMPRESSED_SIGNED_RG11_EAC;          // EAC_R11G11_SNORM
+    default: return GL_NONE;
+  }
+}
+
+KtxLoader::Description KtxLoader::describe(const MappedFile &file)
+{
+  const std::string &path = file.getPath();
+
+  if (file.size() < _HEADER_SIZE || std::memcmp(file.data(), _IDENTIFIER, sizeof(_IDENTIFIER)) != 0)
+    throw FormatError(path, "not a KTX2 file");
+
+  unsigned int vkFormat = _read<uint32_t>(file, 12);
+  size_t width = _read<uint32_t>(file, 20);
+  size_t height = _read<uint32_t>(file, 24);
+  size_t depth = _read<uint32_t>(file, 28);
+  size_t layers = _read<uint32_t>(file, 32);
+  size_t faces = _read<uint32_t>(file, 36);
+  size_t levels = _read<uint32_t>(file, 40);
+  unsigned int supercompression = _read<uint32_t>(file, 44);
+
+  if (supercompression != 0)
+    throw FormatError(path, "supercompressed files are not supported");
+
+  if (width == 0 || height == 0 || depth != 0)
+    throw FormatError(path, "only 2D images are supported");
+
+  if (faces != 1 && faces != 6)
+    throw FormatError(path, "invalid face count");
+
+  Description description;
+  description.internalFormat = getInternalFormat(vkFormat);
+  description.width = width;
+  description.height = height;
+  description.layers = std::max<size_t>(layers, 1);
+  description.faces = faces;
+  // No level means mipmaps to generate, not possible on compressed blocks.
+  description.levels = std::max<size_t>(levels, 1);
+
+  if (faces == 6)
+    description.target = (layers > 0) ? GL_TEXTURE_CUBE_MAP_ARRAY : GL_TEXTURE_CUBE_MAP;
+  else
+    description.target = (layers > 0) ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+
+  if (description.internalFormat == GL_NONE)
+    throw FormatError(path, "not a block compressed format");
+
+  if (!Texture::isCompressedFormatSupported(description.internalFormat, description.target))
+    throw FormatError(path, "compressed format not supported by the driver");
+
+  if (description.levels > Texture::getMipmapLevelCount(width, height))
+    throw FormatError(path, "invalid level count");
+
+  if (_HEADER_SIZE + description.levels * _LEVEL_INDEX_SIZE > file.size())
+    throw FormatError(path, "truncated level index");
+
+  return description;
+}
+
+KtxLoader::KtxLoader(bool prefetching)
+: m_prefetching(prefetching), m_progress()
+{
+
+}
+
+Texture* KtxLoader::load(const std::string &path)
+{
+  MappedFile file(path);
+  return load(file);
+}
+
+Texture* KtxLoader::load(const MappedFile &file)
+{
+  Description description = describe(file);
+  std::unique_ptr<Texture> texture(new Texture());
+
+  texture->bind(description.target);
+  allocate(file, *texture);
+
+  for (size_t level = description.levels; level > 0; --level)
+  {
+    if (m_prefetching && level > 1)
+    {
+      _Level next = _getLevel(file, level - 2);
+      file.prefetch(next.offset, next.size);
+    }
+
+    uploadLevel(file, description, *texture, level - 1);
+  }
+
+  texture->unbind();
+
+  return texture.release();
+}
+
+KtxLoader::Description KtxLoader::allocate(const MappedFile &file, Texture &texture)
+{
+  assert(!texture.isImmutable());
+
+  Description description = describe(file);
+  assert(texture.getTarget() == description.target);
+
+  size_t layerFaces = description.layers * description.faces;
+
+  if (description.target == GL_TEXTURE_2D || description.target == GL_TEXTURE_CUBE_MAP)
+  {
+    texture.allocateStorage(
+      description.levels,
+      description.internalFormat,
+      description.width, description.height
+    );
+  }
+  else
+  {
+    texture.allocateStorage(
+      description.levels,
+      description.internalFormat,
+      description.width, description.height, layerFaces
+    );
+  }
+
+  // Nothing to sample until the smallest level is uploaded.
+  texture.setBaseLevel(description.levels - 1);
+  texture.setMaxLevel(description.levels - 1);
+
+  return description;
+}
+
+void KtxLoader::uploadLevel(
+  const MappedFile &file,
+  const Description &description,
+  Texture &texture,
+  size_t level
+)
+{
+  assert(level < description.levels);
+
+  _Level range = _getLevel(file, level);
+
+  size_t width = std::max<size_t>(description.width >> level, 1);
+  size_t height = std::max<size_t>(description.height >> level, 1);
+  size_t layerFaces = description.layers * description.faces;
+
+  if (range.size != getImageSize(description.internalFormat, width, height, layerFaces))
+    throw FormatError(file.getPath(), "invalid level size");
+
+  // Layers then faces, as OpenGL lays out cube map arrays.
+  const unsigned char *data = file.data() + range.offset;
+
+  if (description.target == GL_TEXTURE_2D)
+  {
+    texture.setCompressedSubData(
+      level,
+      0, 0,
+      width, height,
+      description.internalFormat,
+      range.size,
+      data
+    );
+  }
+  else
+  {
+    texture.setCompressedSubData(
+      level,
+      0, 0, 0,
+      width, height, layerFaces,
+      description.internalFormat,
+      range.size,
+      data
+    );
+  }
+
+  // glCompressedTexSubImage has copied the data, the pages can go.
+  file.release(range.offset, range.size);
+
+  if (level < texture.getBaseLevel())
+    texture.setBaseLevel(level);
+
+  if (m_progress)
+    m_progress(level, description.levels);
+}
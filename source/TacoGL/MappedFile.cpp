@@ -0,0 +1,188 @@
+#include <cassert>
+#include <algorithm>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+#include <TacoGL/MappedFile.h>
+
+using namespace TacoGL;
+
+MappedFile::OpenError::OpenError(const std::string &path, const std::string &reason) throw()
+: m_message(path + ": " + reason)
+{
+
+}
+
+MappedFile::OpenError::~OpenError() throw()
+{
+
+}
+
+const char * MappedFile::OpenError::what() const throw()
+{
+  return m_message.c_str();
+}
+
+size_t MappedFile::getPageSize()
+{
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+#else
+  return sysconf(_SC_PAGESIZE);
+#endif
+}
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path)
+: m_path(path), m_data(nullptr), m_size(0), m_file(nullptr), m_mapping(nullptr)
+{
+  HANDLE file = CreateFileA(
+    path.c_str(),
+    GENERIC_READ,
+    FILE_SHARE_READ,
+    nullptr,
+    OPEN_EXISTING,
+    FILE_FLAG_SEQUENTIAL_SCAN,
+    nullptr
+  );
+
+  if (file == INVALID_HANDLE_VALUE)
+    throw OpenError(path, "can not open file");
+
+  LARGE_INTEGER size;
+  GetFileSizeEx(file, &size);
+  m_file = file;
+  m_size = static_cast<size_t>(size.QuadPart);
+
+  if (m_size == 0)
+    return;
+
+  m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+  if (m_mapping)
+    m_data = static_cast<unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+  if (!m_data)
+  {
+    if (m_mapping)
+      CloseHandle(m_mapping);
+
+    CloseHandle(file);
+    throw OpenError(path, "can not map file");
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  if (m_data)
+    UnmapViewOfFile(m_data);
+
+  if (m_mapping)
+    CloseHandle(m_mapping);
+
+  CloseHandle(m_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path)
+: m_path(path), m_data(nullptr), m_size(0), m_descriptor(-1)
+{
+  m_descriptor = open(path.c_str(), O_RDONLY);
+
+  if (m_descriptor < 0)
+    throw OpenError(path, "can not open file");
+
+  struct stat status;
+  fstat(m_descriptor, &status);
+  m_size = status.st_size;
+
+  if (m_size == 0)
+    return;
+
+  void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_descriptor, 0);
+
+  if (data == MAP_FAILED)
+  {
+    close(m_descriptor);
+    throw OpenError(path, "can not map file");
+  }
+
+  m_data = static_cast<unsigned char*>(data);
+  madvise(m_data, m_size, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+  if (m_data)
+    munmap(m_data, m_size);
+
+  close(m_descriptor);
+}
+
+namespace
+{
+  /**
+   * Extend a range to whole pages, as required by the paging hints.
+   */
+  void _pageRange(size_t &offset, size_t &size, size_t fileSize)
+  {
+    size_t pageSize = MappedFile::getPageSize();
+    size_t end = std::min(offset + size, fileSize);
+
+    offset -= offset % pageSize;
+    size = end - offset;
+  }
+}
+
+#endif
+
+void MappedFile::prefetch(size_t offset, size_t size) const
+{
+  assert(offset + size <= m_size);
+
+  if (size == 0)
+    return;
+
+#ifndef _WIN32
+  _pageRange(offset, size, m_size);
+  madvise(m_data + offset, size, MADV_WILLNEED);
+#endif
+}
+
+void MappedFile::touch(size_t offset, size_t size) const
+{
+  assert(offset + size <= m_size);
+
+  size_t pageSize = getPageSize();
+  volatile unsigned char sink = 0;
+
+  for (size_t i = offset; i < offset + size; i += pageSize)
+  {
+    sink = sink + m_data[i];
+  }
+}
+
+void MappedFile::release(size_t offset, size_t size) const
+{
+  assert(offset + size <= m_size);
+
+  if (size == 0)
+    return;
+
+#ifndef _WIN32
+  // Clean file pages, dropped pages are read again on next access.
+  _pageRange(offset, size, m_size);
+  madvise(m_data + offset, size, MADV_DONTNEED);
+#endif
+}
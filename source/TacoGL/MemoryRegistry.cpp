@@ -0,0 +1,139 @@
+#include <cassert>
+
+#include <TacoGL/MemoryRegistry.h>
+
+using namespace TacoGL;
+
+const size_t MemoryRegistry::CATEGORY_COUNT;
+
+std::unordered_map<const Object*, MemoryRegistry::Entry> MemoryRegistry::s_entries;
+std::array<MemoryRegistry::Usage, MemoryRegistry::CATEGORY_COUNT> MemoryRegistry::s_usage = {};
+MemoryRegistry::BudgetCallback MemoryRegistry::s_callback;
+
+std::string MemoryRegistry::getCategoryName(Category category)
+{
+  switch (category)
+  {
+    case Category::BUFFER: return "Buffer";
+    case Category::TEXTURE: return "Texture";
+    case Category::RENDERBUFFER: return "Renderbuffer";
+    default: return "Total";
+  }
+}
+
+void MemoryRegistry::update(Category category, const Object *object, size_t size)
+{
+  assert(category != Category::TOTAL);
+
+  auto it = s_entries.find(object);
+
+  if (it != s_entries.end())
+  {
+    subtract(it->second.category, it->second.size);
+    it->second = Entry{category, size};
+  }
+  else
+  {
+    s_entries.emplace(object, Entry{category, size});
+  }
+
+  add(category, size);
+}
+
+void MemoryRegistry::remove(const Object *object)
+{
+  auto it = s_entries.find(object);
+
+  if (it == s_entries.end())
+    return;
+
+  subtract(it->second.category, it->second.size);
+  s_entries.erase(it);
+}
+
+const MemoryRegistry::Usage & MemoryRegistry::getUsage(Category category)
+{
+  return s_usage[static_cast<size_t>(category)];
+}
+
+void MemoryRegistry::setBudget(Category category, size_t budget)
+{
+  s_usage[static_cast<size_t>(category)].budget = budget;
+}
+
+void MemoryRegistry::setBudgetCallback(const BudgetCallback &callback)
+{
+  s_callback = callback;
+}
+
+void MemoryRegistry::resetPeaks()
+{
+  for (Usage &usage : s_usage)
+  {
+    usage.peak = usage.size;
+  }
+}
+
+void MemoryRegistry::dump(std::ostream &stream, bool objects)
+{
+  stream << "GPU memory usage (bytes)" << std::endl;
+
+  for (size_t i = 0; i < CATEGORY_COUNT; ++i)
+  {
+    const Usage &usage = s_usage[i];
+
+    stream << getCategoryName(static_cast<Category>(i))
+      << ": size " << usage.size
+      << ", peak " << usage.peak
+      << ", objects " << usage.count;
+
+    if (usage.budget)
+      stream << ", budget " << usage.budget;
+
+    stream << std::endl;
+  }
+
+  if (objects)
+  {
+    for (auto &item : s_entries)
+    {
+      stream << getCategoryName(item.second.category)
+        << " " << item.first->getId()
+        << ": " << item.second.size << std::endl;
+    }
+  }
+}
+
+void MemoryRegistry::add(Category category, size_t size)
+{
+  Category categories[2] = {category, Category::TOTAL};
+
+  for (Category current : categories)
+  {
+    Usage &usage = s_usage[static_cast<size_t>(current)];
+
+    usage.size += size;
+    usage.count += 1;
+
+    if (usage.size > usage.peak)
+      usage.peak = usage.size;
+
+    if (usage.budget && usage.size > usage.budget && size > 0 && s_callback)
+      s_callback(current, usage);
+  }
+}
+
+void MemoryRegistry::subtract(Category category, size_t size)
+{
+  Category categories[2] = {category, Category::TOTAL};
+
+  for (Category current : categories)
+  {
+    Usage &usage = s_usage[static_cast<size_t>(current)];
+
+    assert(usage.size >= size && usage.count > 0);
+
+    usage.size -= size;
+    usage.count -= 1;
+  }
+}
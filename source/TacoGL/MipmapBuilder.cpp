@@ -0,0 +1,495 @@
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <TacoGL/MappedFile.h>
+#include <TacoGL/MipmapBuilder.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+namespace
+{
+  const char _MAGIC[8] = {'T', 'G', 'L', 'M', 'I', 'P', 'S', '1'};
+
+  /**
+   * Number of rows per range handed to the threads.
+   */
+  const size_t _BAND_ROWS = 8;
+
+  //---------//
+  // Filters //
+  //---------//
+
+  const float _PI = 3.14159265358979f;
+
+  float _sinc(float x)
+  {
+    if (std::fabs(x) < 1e-6f)
+      return 1.0f;
+
+    return std::sin(_PI * x) / (_PI * x);
+  }
+
+  /**
+   * Modified Bessel function of the first kind, order 0.
+   */
+  float _besselI0(float x)
+  {
+    float sum = 1.0f, term = 1.0f;
+
+    for (int k = 1; k < 20; ++k)
+    {
+      term *= (x / (2.0f * k)) * (x / (2.0f * k));
+      sum += term;
+    }
+
+    return sum;
+  }
+
+  /**
+   * Retrieve the half width of a filter, in destination texels.
+   */
+  float _getSupport(MipmapBuilder::Filter filter)
+  {
+    return (filter == MipmapBuilder::Filter::BOX) ? 0.5f : 3.0f;
+  }
+
+  float _evaluate(MipmapBuilder::Filter filter, float x)
+  {
+    float support = _getSupport(filter);
+    x = std::fabs(x);
+
+    switch (filter)
+    {
+      case MipmapBuilder::Filter::BOX:
+        return (x <= support) ? 1.0f : 0.0f;
+
+      case MipmapBuilder::Filter::KAISER:
+      {
+        const float alpha = 4.0f;
+
+        if (x >= support)
+          return 0.0f;
+
+        float ratio = x / support;
+        return _sinc(x) * _besselI0(alpha * std::sqrt(1.0f - ratio * ratio)) / _besselI0(alpha);
+      }
+
+      case MipmapBuilder::Filter::LANCZOS:
+        return (x < support) ? _sinc(x) * _sinc(x / support) : 0.0f;
+    }
+
+    return 0.0f;
+  }
+
+  /**
+   * Source texels and weights of each destination texel, along one
+   * dimension.
+   */
+  struct _Weights
+  {
+    std::vector<size_t> first; ///< the first source texel of each destination texel.
+    std::vector<float> weights; ///< taps weights per destination texel.
+    size_t taps;
+  };
+
+  _Weights _computeWeights(MipmapBuilder::Filter filter, size_t source, size_t destination)
+  {
+    float scale = static_cast<float>(source) / destination;
+    float radius = _getSupport(filter) * scale;
+
+    _Weights weights;
+    weights.taps = static_cast<size_t>(std::ceil(2.0f * radius)) + 1;
+    weights.first.resize(destination);
+    weights.weights.assign(destination * weights.taps, 0.0f);
+
+    for (size_t x = 0; x < destination; ++x)
+    {
+      float center = (x + 0.5f) * scale - 0.5f;
+      long first = static_cast<long>(std::ceil(center - radius));
+
+      // Taps past the edges fall back on the edge texels.
+      float *row = &weights.weights[x * weights.taps];
+      float sum = 0.0f;
+
+      weights.first[x] = std::min<long>(std::max<long>(first, 0), source - 1);
+
+      for (size_t tap = 0; tap < weights.taps; ++tap)
+      {
+        long texel = first + static_cast<long>(tap);
+        float weight = _evaluate(filter, (texel - center) / scale);
+
+        long clamped = std::min<long>(std::max<long>(texel, 0), source - 1);
+        size_t index = std::min<size_t>(clamped - weights.first[x], weights.taps - 1);
+
+        row[index] += weight;
+        sum += weight;
+      }
+
+      for (size_t tap = 0; tap < weights.taps; ++tap)
+        row[tap] /= sum;
+    }
+
+    return weights;
+  }
+
+  //------------//
+  // Conversion //
+  //------------//
+
+  float _decodeSrgb(float value)
+  {
+    return (value <= 0.04045f) ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+  }
+
+  /**
+   * Byte to float tables, and the linear thresholds between sRGB bytes.
+   */
+  struct _Tables
+  {
+    float linear[256];
+    float srgb[256];
+    float thresholds[255]; ///< linear values halfway between sRGB bytes.
+
+    _Tables()
+    {
+      for (size_t i = 0; i < 256; ++i)
+      {
+        linear[i] = i / 255.0f;
+        srgb[i] = _decodeSrgb(i / 255.0f);
+      }
+
+      for (size_t i = 0; i < 255; ++i)
+        thresholds[i] = _decodeSrgb((i + 0.5f) / 255.0f);
+    }
+  };
+
+  const _Tables& _getTables()
+  {
+    static const _Tables tables;
+    return tables;
+  }
+
+  unsigned char _encode(float value, bool srgb, const _Tables &tables)
+  {
+    if (srgb)
+      return std::upper_bound(tables.thresholds, tables.thresholds + 255, value) - tables.thresholds;
+
+    return static_cast<unsigned char>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+  }
+
+  //--------//
+  // Passes //
+  //--------//
+
+  /**
+   * Resample rows horizontally, RGBA texels.
+   */
+  void _filterRows(
+    const float *source, size_t sourceWidth,
+    float *destination, size_t destinationWidth,
+    const _Weights &weights,
+    size_t first, size_t last
+  )
+  {
+    for (size_t y = first; y < last; ++y)
+    {
+      const float *in = source + 4 * y * sourceWidth;
+      float *out = destination + 4 * y * destinationWidth;
+
+      for (size_t x = 0; x < destinationWidth; ++x)
+      {
+        const float *texel = in + 4 * weights.first[x];
+        const float *w = &weights.weights[x * weights.taps];
+        size_t taps = std::min(weights.taps, sourceWidth - weights.first[x]);
+
+#if defined(__AVX2__) || defined(__SSE2__)
+        // One texel per register.
+        __m128 sum = _mm_setzero_ps();
+
+        for (size_t tap = 0; tap < taps; ++tap)
+          sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[tap]), _mm_loadu_ps(texel + 4 * tap)));
+
+        _mm_storeu_ps(out + 4 * x, sum);
+#else
+        float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+        for (size_t tap = 0; tap < taps; ++tap)
+          for (size_t c = 0; c < 4; ++c)
+            sum[c] += w[tap] * texel[4 * tap + c];
+
+        std::memcpy(out + 4 * x, sum, sizeof(sum));
+#endif
+      }
+    }
+  }
+
+  /**
+   * Resample columns vertically, whole rows of floats at once.
+   */
+  void _filterColumns(
+    const float *source, size_t sourceHeight,
+    float *destination,
+    size_t rowSize,
+    const _Weights &weights,
+    size_t first, size_t last
+  )
+  {
+    for (size_t y = first; y < last; ++y)
+    {
+      const float *w = &weights.weights[y * weights.taps];
+      const float *in = source + weights.first[y] * rowSize;
+      float *out = destination + y * rowSize;
+      size_t taps = std::min(weights.taps, sourceHeight - weights.first[y]);
+      size_t i = 0;
+
+#if defined(__AVX2__)
+      for (; i + 8 <= rowSize; i += 8)
+      {
+        __m256 sum = _mm256_setzero_ps();
+
+        for (size_t tap = 0; tap < taps; ++tap)
+          sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(w[tap]), _mm256_loadu_ps(in + tap * rowSize + i)));
+
+        _mm256_storeu_ps(out + i, sum);
+      }
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+      for (; i + 4 <= rowSize; i += 4)
+      {
+        __m128 sum = _mm_setzero_ps();
+
+        for (size_t tap = 0; tap < taps; ++tap)
+          sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[tap]), _mm_loadu_ps(in + tap * rowSize + i)));
+
+        _mm_storeu_ps(out + i, sum);
+      }
+#endif
+      for (; i < rowSize; ++i)
+      {
+        float sum = 0.0f;
+
+        for (size_t tap = 0; tap < taps; ++tap)
+          sum += w[tap] * in[tap * rowSize + i];
+
+        out[i] = sum;
+      }
+    }
+  }
+
+  //-------//
+  // Cache //
+  //-------//
+
+  void _write32(std::ofstream &stream, uint32_t value)
+  {
+    unsigned char bytes[4];
+
+    for (size_t i = 0; i < 4; ++i)
+      bytes[i] = (value >> (8 * i)) & 0xFF;
+
+    stream.write(reinterpret_cast<const char*>(bytes), 4);
+  }
+
+  uint32_t _read32(const unsigned char *data)
+  {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+  }
+}
+
+//------------//
+// CacheError //
+//------------//
+
+MipmapBuilder::CacheError::CacheError(const std::string &path, const std::string &reason) throw()
+: m_message(path + ": " + reason)
+{
+
+}
+
+MipmapBuilder::CacheError::~CacheError() throw()
+{
+
+}
+
+const char * MipmapBuilder::CacheError::what() const throw()
+{
+  return m_message.c_str();
+}
+
+//---------------//
+// MipmapBuilder //
+//---------------//
+
+void MipmapBuilder::save(const std::string &path, const std::vector<Level> &levels)
+{
+  std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+
+  if (!stream)
+    throw CacheError(path, "can not open for writing");
+
+  stream.write(_MAGIC, sizeof(_MAGIC));
+  _write32(stream, levels.size());
+
+  for (const Level &level : levels)
+  {
+    assert(level.pixels.size() == 4 * level.width * level.height);
+
+    _write32(stream, level.width);
+    _write32(stream, level.height);
+    stream.write(reinterpret_cast<const char*>(level.pixels.data()), level.pixels.size());
+  }
+
+  if (!stream)
+    throw CacheError(path, "write failed");
+}
+
+std::vector<MipmapBuilder::Level> MipmapBuilder::load(const std::string &path)
+{
+  MappedFile file(path);
+  const unsigned char *data = file.data();
+  size_t offset = sizeof(_MAGIC) + 4;
+
+  if (file.size() < offset || std::memcmp(data, _MAGIC, sizeof(_MAGIC)) != 0)
+    throw CacheError(path, "not a mipmap cache");
+
+  // Each level takes at least its 8 bytes header.
+  size_t count = _read32(data + sizeof(_MAGIC));
+
+  if (count > (file.size() - offset) / 8)
+    throw CacheError(path, "invalid level count");
+
+  std::vector<Level> levels(count);
+
+  for (Level &level : levels)
+  {
+    if (file.size() - offset < 8)
+      throw CacheError(path, "truncated level header");
+
+    level.width = _read32(data + offset);
+    level.height = _read32(data + offset + 4);
+    offset += 8;
+
+    size_t size = 4 * level.width * level.height;
+
+    if (file.size() - offset < size)
+      throw CacheError(path, "truncated level data");
+
+    level.pixels.assign(data + offset, data + offset + size);
+    offset += size;
+  }
+
+  return levels;
+}
+
+MipmapBuilder::MipmapBuilder(Filter filter, bool srgb, ThreadPool *pool)
+: m_filter(filter), m_srgb(srgb), m_pool(pool ? pool : &ThreadPool::getGlobal())
+{
+
+}
+
+std::vector<MipmapBuilder::Level> MipmapBuilder::build(
+  const unsigned char *pixels,
+  size_t width, size_t height,
+  size_t levels
+) const
+{
+  assert(width > 0 && height > 0);
+
+  size_t count = Texture::getMipmapLevelCount(width, height);
+  levels = (levels == 0) ? count : std::min(levels, count);
+
+  const _Tables &tables = _getTables();
+  const float *colorTable = m_srgb ? tables.srgb : tables.linear;
+
+  // Base level in linear float.
+  std::vector<float> source(4 * width * height);
+
+  m_pool->run(height, [&](size_t first, size_t last) {
+    for (size_t i = 4 * first * width; i < 4 * last * width; i += 4)
+    {
+      source[i] = colorTable[pixels[i]];
+      source[i + 1] = colorTable[pixels[i + 1]];
+      source[i + 2] = colorTable[pixels[i + 2]];
+      source[i + 3] = tables.linear[pixels[i + 3]];
+    }
+  }, _BAND_ROWS);
+
+  std::vector<Level> chain;
+  std::vector<float> rows, destination;
+
+  for (size_t level = 1; level < levels; ++level)
+  {
+    size_t levelWidth = std::max<size_t>(width >> 1, 1);
+    size_t levelHeight = std::max<size_t>(height >> 1, 1);
+
+    _Weights horizontal = _computeWeights(m_filter, width, levelWidth);
+    _Weights vertical = _computeWeights(m_filter, height, levelHeight);
+
+    rows.resize(4 * levelWidth * height);
+    destination.resize(4 * levelWidth * levelHeight);
+
+    m_pool->run(height, [&](size_t first, size_t last) {
+      _filterRows(source.data(), width, rows.data(), levelWidth, horizontal, first, last);
+    }, _BAND_ROWS);
+
+    m_pool->run(levelHeight, [&](size_t first, size_t last) {
+      _filterColumns(rows.data(), height, destination.data(), 4 * levelWidth, vertical, first, last);
+    }, _BAND_ROWS);
+
+    Level result;
+    result.width = levelWidth;
+    result.height = levelHeight;
+    result.pixels.resize(4 * levelWidth * levelHeight);
+
+    m_pool->run(levelHeight, [&](size_t first, size_t last) {
+      for (size_t i = 4 * first * levelWidth; i < 4 * last * levelWidth; i += 4)
+      {
+        result.pixels[i] = _encode(destination[i], m_srgb, tables);
+        result.pixels[i + 1] = _encode(destination[i + 1], m_srgb, tables);
+        result.pixels[i + 2] = _encode(destination[i + 2], m_srgb, tables);
+        result.pixels[i + 3] = _encode(destination[i + 3], false, tables);
+      }
+    }, _BAND_ROWS);
+
+    chain.push_back(std::move(result));
+
+    // The next level is filtered from the unquantized one.
+    source.swap(destination);
+    width = levelWidth;
+    height = levelHeight;
+  }
+
+  return chain;
+}
+
+void MipmapBuilder::upload(Texture &texture, const std::vector<Level> &levels)
+{
+  assert(texture.isBinded());
+
+  GLenum internalFormat = texture.getInternalFormat(0);
+
+  for (size_t i = 0; i < levels.size(); ++i)
+  {
+    const Level &level = levels[i];
+
+    texture.setData(
+      i + 1,
+      GL_RGBA,
+      internalFormat,
+      GL_UNSIGNED_BYTE,
+      level.width, level.height,
+      const_cast<unsigned char*>(level.pixels.data())
+    );
+  }
+}
@@ -0,0 +1,292 @@
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <TacoGL/OffsetAllocator.h>
+
+using namespace TacoGL;
+
+const OffsetAllocator::NodeIndex OffsetAllocator::INVALID_NODE;
+const size_t OffsetAllocator::SECOND_LEVEL_BITS;
+const size_t OffsetAllocator::SECOND_LEVEL_COUNT;
+const size_t OffsetAllocator::FIRST_LEVEL_COUNT;
+
+namespace
+{
+  inline size_t highestBit(uint64_t value)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+  }
+
+  inline size_t lowestBit(uint64_t value)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#else
+    return __builtin_ctzll(value);
+#endif
+  }
+
+  /**
+   * Find the bin holding ranges of the given size.
+   */
+  inline void mapping(size_t size, size_t &firstLevel, size_t &secondLevel, size_t bits)
+  {
+    if (size < (size_t(1) << bits))
+    {
+      firstLevel = 0;
+      secondLevel = size;
+    }
+    else
+    {
+      size_t bit = highestBit(size);
+      firstLevel = bit - bits + 1;
+      secondLevel = (size >> (bit - bits)) ^ (size_t(1) << bits);
+    }
+  }
+
+  /**
+   * Round a size up to the next bin boundary, so any range of the found
+   * bin is large enough.
+   */
+  inline size_t roundUp(size_t size, size_t bits)
+  {
+    if (size < (size_t(1) << bits))
+      return size;
+
+    size_t round = (size_t(1) << (highestBit(size) - bits)) - 1;
+    return size + round;
+  }
+}
+
+OffsetAllocator::OffsetAllocator(size_t size)
+: m_size(size)
+{
+  reset();
+}
+
+void OffsetAllocator::reset()
+{
+  m_nodes.clear();
+  m_unusedNodes.clear();
+
+  m_firstLevelMap = 0;
+  for (size_t i = 0; i < FIRST_LEVEL_COUNT; ++i)
+  {
+    m_secondLevelMap[i] = 0;
+    for (size_t j = 0; j < SECOND_LEVEL_COUNT; ++j)
+    {
+      m_bins[i][j] = INVALID_NODE;
+    }
+  }
+
+  m_freeSize = 0;
+  m_freeCount = 0;
+  m_allocationCount = 0;
+
+  if (m_size > 0)
+  {
+    insertFree(createNode(0, m_size));
+  }
+}
+
+OffsetAllocator::Allocation OffsetAllocator::allocate(size_t size)
+{
+  assert(size > 0);
+
+  size_t firstLevel, secondLevel;
+  mapping(roundUp(size, SECOND_LEVEL_BITS), firstLevel, secondLevel, SECOND_LEVEL_BITS);
+
+  if (firstLevel >= FIRST_LEVEL_COUNT)
+    return Allocation{0, 0, INVALID_NODE};
+
+  // Look for a non empty bin in the same first level, then above.
+  uint64_t secondLevelMap = m_secondLevelMap[firstLevel] & (~uint64_t(0) << secondLevel);
+
+  if (secondLevelMap == 0)
+  {
+    uint64_t firstLevelMap = (firstLevel + 1 < 64)
+      ? m_firstLevelMap & (~uint64_t(0) << (firstLevel + 1))
+      : 0;
+
+    if (firstLevelMap == 0)
+      return Allocation{0, 0, INVALID_NODE};
+
+    firstLevel = lowestBit(firstLevelMap);
+    secondLevelMap = m_secondLevelMap[firstLevel];
+  }
+
+  secondLevel = lowestBit(secondLevelMap);
+
+  NodeIndex index = m_bins[firstLevel][secondLevel];
+  assert(index != INVALID_NODE);
+
+  removeFree(index);
+
+  // Give the remainder back to the free bins.
+  Node &node = m_nodes[index];
+  if (node.size > size)
+  {
+    NodeIndex remainder = createNode(m_nodes[index].offset + size, m_nodes[index].size - size);
+
+    Node &split = m_nodes[index];
+    split.size = size;
+
+    m_nodes[remainder].previous = index;
+    m_nodes[remainder].next = split.next;
+    if (split.next != INVALID_NODE)
+      m_nodes[split.next].previous = remainder;
+    split.next = remainder;
+
+    insertFree(remainder);
+  }
+
+  m_nodes[index].used = true;
+  ++m_allocationCount;
+
+  return Allocation{m_nodes[index].offset, size, index};
+}
+
+void OffsetAllocator::free(const Allocation &allocation)
+{
+  assert(allocation.isValid());
+
+  NodeIndex index = allocation.node;
+  assert(m_nodes[index].used);
+
+  m_nodes[index].used = false;
+  --m_allocationCount;
+
+  // Merge with the previous free neighbour.
+  NodeIndex previous = m_nodes[index].previous;
+  if (previous != INVALID_NODE && !m_nodes[previous].used)
+  {
+    removeFree(previous);
+
+    m_nodes[previous].size += m_nodes[index].size;
+    m_nodes[previous].next = m_nodes[index].next;
+    if (m_nodes[index].next != INVALID_NODE)
+      m_nodes[m_nodes[index].next].previous = previous;
+
+    destroyNode(index);
+    index = previous;
+  }
+
+  // Merge with the next free neighbour.
+  NodeIndex next = m_nodes[index].next;
+  if (next != INVALID_NODE && !m_nodes[next].used)
+  {
+    removeFree(next);
+
+    m_nodes[index].size += m_nodes[next].size;
+    m_nodes[index].next = m_nodes[next].next;
+    if (m_nodes[next].next != INVALID_NODE)
+      m_nodes[m_nodes[next].next].previous = index;
+
+    destroyNode(next);
+  }
+
+  insertFree(index);
+}
+
+OffsetAllocator::Statistics OffsetAllocator::getStatistics() const
+{
+  size_t largest = 0;
+
+  if (m_firstLevelMap != 0)
+  {
+    size_t firstLevel = highestBit(m_firstLevelMap);
+    size_t secondLevel = highestBit(m_secondLevelMap[firstLevel]);
+
+    for (NodeIndex index = m_bins[firstLevel][secondLevel]; index != INVALID_NODE; index = m_nodes[index].nextFree)
+    {
+      if (m_nodes[index].size > largest)
+        largest = m_nodes[index].size;
+    }
+  }
+
+  return Statistics{m_size, m_freeSize, largest, m_freeCount, m_allocationCount};
+}
+
+//-----------------//
+// Node management //
+//-----------------//
+
+OffsetAllocator::NodeIndex OffsetAllocator::createNode(size_t offset, size_t size)
+{
+  Node node = Node{offset, size, false, INVALID_NODE, INVALID_NODE, INVALID_NODE, INVALID_NODE};
+
+  if (!m_unusedNodes.empty())
+  {
+    NodeIndex index = m_unusedNodes.back();
+    m_unusedNodes.pop_back();
+    m_nodes[index] = node;
+    return index;
+  }
+
+  m_nodes.push_back(node);
+  return static_cast<NodeIndex>(m_nodes.size() - 1);
+}
+
+void OffsetAllocator::destroyNode(NodeIndex index)
+{
+  m_unusedNodes.push_back(index);
+}
+
+void OffsetAllocator::insertFree(NodeIndex index)
+{
+  Node &node = m_nodes[index];
+
+  size_t firstLevel, secondLevel;
+  mapping(node.size, firstLevel, secondLevel, SECOND_LEVEL_BITS);
+
+  NodeIndex head = m_bins[firstLevel][secondLevel];
+
+  node.previousFree = INVALID_NODE;
+  node.nextFree = head;
+  if (head != INVALID_NODE)
+    m_nodes[head].previousFree = index;
+
+  m_bins[firstLevel][secondLevel] = index;
+  m_secondLevelMap[firstLevel] |= uint32_t(1) << secondLevel;
+  m_firstLevelMap |= uint64_t(1) << firstLevel;
+
+  m_freeSize += node.size;
+  ++m_freeCount;
+}
+
+void OffsetAllocator::removeFree(NodeIndex index)
+{
+  Node &node = m_nodes[index];
+
+  size_t firstLevel, secondLevel;
+  mapping(node.size, firstLevel, secondLevel, SECOND_LEVEL_BITS);
+
+  if (node.previousFree != INVALID_NODE)
+    m_nodes[node.previousFree].nextFree = node.nextFree;
+  else
+    m_bins[firstLevel][secondLevel] = node.nextFree;
+
+  if (node.nextFree != INVALID_NODE)
+    m_nodes[node.nextFree].previousFree = node.previousFree;
+
+  if (m_bins[firstLevel][secondLevel] == INVALID_NODE)
+  {
+    m_secondLevelMap[firstLevel] &= ~(uint32_t(1) << secondLevel);
+    if (m_secondLevelMap[firstLevel] == 0)
+      m_firstLevelMap &= ~(uint64_t(1) << firstLevel);
+  }
+
+  m_freeSize -= node.size;
+  --m_freeCount;
+}
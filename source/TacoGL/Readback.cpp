@@ -0,0 +1,76 @@
+#include <cassert>
+
+#include <TacoGL/Readback.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+Readback::Readback(size_t capacity)
+: m_buffer(), m_fence(), m_data(nullptr), m_size(0)
+{
+  bool binding = !Buffer::isDirectStateAccessEnabled();
+
+  if (binding)
+    m_buffer.bind(GL_COPY_WRITE_BUFFER);
+
+  m_buffer.allocate<unsigned char>(
+    capacity,
+    GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT
+  );
+
+  m_data = m_buffer.mapData(
+    0,
+    capacity,
+    GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT
+  );
+
+  if (binding)
+    m_buffer.unbind();
+}
+
+Readback::~Readback()
+{
+  bool binding = !Buffer::isDirectStateAccessEnabled();
+
+  if (binding)
+    m_buffer.bind(GL_COPY_WRITE_BUFFER);
+
+  m_buffer.unmap();
+
+  if (binding)
+    m_buffer.unbind();
+}
+
+void Readback::read(const Buffer &source, size_t offset, size_t size)
+{
+  assert(size <= getCapacity());
+
+  if (Buffer::isDirectStateAccessEnabled())
+  {
+    m_buffer.copy(source, offset, 0, size);
+  }
+  else
+  {
+    assert(source.getTarget() != GL_COPY_WRITE_BUFFER);
+
+    m_buffer.bind(GL_COPY_WRITE_BUFFER);
+    m_buffer.copy(source, offset, 0, size);
+    m_buffer.unbind();
+  }
+
+  fence(size);
+}
+
+void Readback::fence(size_t size)
+{
+  assert(size <= getCapacity());
+
+  m_size = size;
+  m_fence.set();
+}
+
+const void* Readback::data()
+{
+  m_fence.wait();
+  return m_data;
+}
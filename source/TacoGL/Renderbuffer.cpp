@@ -1,3 +1,5 @@
+#include <TacoGL/format.h>
+#include <TacoGL/MemoryRegistry.h>
 
 #include <TacoGL/Renderbuffer.h>
 
@@ -11,6 +13,7 @@ Renderbuffer::Renderbuffer()
 
 Renderbuffer::~Renderbuffer()
 {
+  MemoryRegistry::remove(this);
   glDeleteRenderbuffers(1, &m_id);
 }
 
@@ -27,4 +30,10 @@ void Renderbuffer::unbind()
 void Renderbuffer::allocate(gl::GLenum internalFormat, size_t width, size_t height)
 {
   glRenderbufferStorage(GL_RENDERBUFFER, internalFormat, width, height);
+
+  MemoryRegistry::update(
+    MemoryRegistry::Category::RENDERBUFFER,
+    this,
+    getImageSize(internalFormat, width, height)
+  );
 }
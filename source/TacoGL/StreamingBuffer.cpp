@@ -0,0 +1,86 @@
+#include <cassert>
+
+#include <TacoGL/StreamingBuffer.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+namespace
+{
+  inline size_t align(size_t value, size_t alignment)
+  {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+}
+
+StreamingBuffer::StreamingBuffer(size_t segmentSize, size_t segmentCount, size_t alignment)
+: m_buffer(),
+  m_fences(segmentCount),
+  m_data(nullptr),
+  m_segmentSize(align(segmentSize, alignment)),
+  m_alignment(alignment),
+  m_segment(0),
+  m_used(0)
+{
+  assert(segmentCount > 0);
+
+  size_t size = m_segmentSize * segmentCount;
+
+  bool binding = !Buffer::isDirectStateAccessEnabled();
+
+  if (binding)
+    m_buffer.bind(GL_COPY_WRITE_BUFFER);
+
+  m_buffer.allocate<unsigned char>(
+    size,
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT
+  );
+
+  m_data = static_cast<unsigned char*>(m_buffer.mapData(
+    0,
+    size,
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT
+  ));
+
+  if (binding)
+    m_buffer.unbind();
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+  bool binding = !Buffer::isDirectStateAccessEnabled();
+
+  if (binding)
+    m_buffer.bind(GL_COPY_WRITE_BUFFER);
+
+  m_buffer.unmap();
+
+  if (binding)
+    m_buffer.unbind();
+}
+
+void StreamingBuffer::begin()
+{
+  m_fences[m_segment].wait();
+  m_fences[m_segment].reset();
+  m_used = 0;
+}
+
+void* StreamingBuffer::allocate(size_t size, size_t &offset)
+{
+  size_t start = align(m_used, m_alignment);
+
+  if (start + size > m_segmentSize)
+    return nullptr;
+
+  m_used = start + size;
+  offset = getSegmentOffset() + start;
+
+  return m_data + offset;
+}
+
+void StreamingBuffer::end()
+{
+  m_fences[m_segment].set();
+  m_segment = (m_segment + 1) % m_fences.size();
+}
@@ -1,77 +1,257 @@
 #include <cassert>
 #include <algorithm>
 
+#include <glbinding/ContextInfo.h>
+#include <glbinding/Version.h>
+
 #include <TacoGL/get.h>
+#include <TacoGL/format.h>
+#include <TacoGL/MemoryRegistry.h>
+#include <TacoGL/ExtensionRegister.h>
+#include <TacoGL/Readback.h>
+#include <TacoGL/IndexedBinding.h>
 
 #include <TacoGL/Texture.h>
 
 using namespace gl;
+using namespace glbinding;
 using namespace TacoGL;
 
 //==============//
 // Unit Manager //
 //==============//
 
+const size_t TextureUnitManager::INVALID_UNIT = static_cast<size_t>(-1);
+
+TextureUnitManager::TextureUnitManager()
+: m_units(), m_lru(), m_lruPosition(), m_residency(), m_activeUnit(INVALID_UNIT)
+{
+
+}
+
+void TextureUnitManager::initialize()
+{
+  if (!m_units.empty())
+    return;
+
+  size_t count = Texture::getTextureUnitCount();
+  assert(count > 1);
+
+  m_units.assign(count, Unit{0, GL_NONE, 0, false});
+  m_lruPosition.resize(count, m_lru.end());
+
+  // Unit 0 is left for explicit bindings.
+  for (size_t unit = 1; unit < count; ++unit)
+  {
+    m_lruPosition[unit] = m_lru.insert(m_lru.end(), unit);
+  }
+}
+
+size_t TextureUnitManager::getUnitCount() const
+{
+  return m_units.size();
+}
+
 bool TextureUnitManager::isAvaible(size_t unit) const
 {
-  return (m_unitUsage.find(unit) == m_unitUsage.end());
+  return unit >= m_units.size() || m_units[unit].textureId == 0;
 }
 
 bool TextureUnitManager::isBinded(gl::GLuint textureId) const
 {
-  return (m_unitBinding.find(textureId) != m_unitBinding.end());
+  return (m_residency.find(textureId) != m_residency.end());
 }
 
 size_t TextureUnitManager::getUnitBinding(gl::GLuint textureId) const
 {
-  return m_unitBinding.at(textureId).first;
+  return m_residency.at(textureId);
 }
 
 gl::GLenum TextureUnitManager::getTargetBinding(gl::GLuint textureId) const
 {
-  return m_unitBinding.at(textureId).second;
+  return m_units[getUnitBinding(textureId)].target;
 }
 
-void TextureUnitManager::bind(size_t unit, GLenum target, GLuint textureId, GLuint samplerId)
+void TextureUnitManager::touch(size_t unit)
 {
+  if (m_lruPosition[unit] != m_lru.end())
+    m_lru.splice(m_lru.end(), m_lru, m_lruPosition[unit]);
+}
+
+size_t TextureUnitManager::evict(const std::vector<bool> &reserved)
+{
+  for (size_t unit : m_lru)
+  {
+    if (!m_units[unit].pinned && !reserved[unit])
+      return unit;
+  }
+
+  assert(false && "all texture units are pinned");
+  return m_lru.front();
+}
+
+void TextureUnitManager::record(size_t unit, GLenum target, GLuint textureId, GLuint samplerId)
+{
+  Unit &binding = m_units[unit];
+
+  if (binding.textureId)
+    m_residency.erase(binding.textureId);
+
+  // A texture is tracked on a single unit.
   if (isBinded(textureId))
   {
-    if (getUnitBinding(textureId) == unit)
-      return;
-    else
-      unbind(textureId);
+    Unit &previous = m_units[getUnitBinding(textureId)];
+    previous.textureId = 0;
+    previous.target = GL_NONE;
+    previous.pinned = false;
   }
 
-  assert(isAvaible(unit));
+  binding.textureId = textureId;
+  binding.target = target;
+  binding.samplerId = samplerId;
+  binding.pinned = false;
 
-  Texture::setActiveTextureUnit(unit);
+  m_residency[textureId] = unit;
+}
+
+void TextureUnitManager::bind(size_t unit, GLenum target, GLuint textureId, GLuint samplerId)
+{
+  initialize();
+  assert(unit < m_units.size());
+
+  Unit &binding = m_units[unit];
 
-  glBindTexture(target, textureId);
+  if (binding.textureId != textureId || binding.target != target)
+  {
+    setActiveUnit(unit);
+    glBindTexture(target, textureId);
+    record(unit, target, textureId, binding.samplerId);
+    m_created.insert(textureId);
+  }
 
-  if (samplerId)
+  if (binding.samplerId != samplerId)
   {
     glBindSampler(unit, samplerId);
+    binding.samplerId = samplerId;
   }
 
-  m_unitUsage.insert(unit);
-  m_unitBinding.emplace(textureId, BindingPair{unit, target});
+  binding.pinned = true;
+  touch(unit);
 }
 
 size_t TextureUnitManager::bind(GLenum target, GLuint textureId, GLuint samplerId)
 {
-  size_t unit = 1;
+  std::vector<Request> requests{Request{target, textureId, samplerId, INVALID_UNIT}};
+  bind(requests);
+
+  return requests.front().unit;
+}
+
+void TextureUnitManager::bind(std::vector<Request> &requests)
+{
+  initialize();
 
-  for (;unit < 8; ++unit)
+  std::vector<bool> reserved(m_units.size(), false);
+  std::vector<size_t> dirty;
+  size_t misses = 0;
+
+  // Hits first, so that misses do not evict them.
+  for (Request &request : requests)
   {
-    if (isAvaible(unit))
+    request.unit = INVALID_UNIT;
+
+    if (!isBinded(request.textureId))
+    {
+      ++misses;
+      continue;
+    }
+
+    size_t unit = getUnitBinding(request.textureId);
+
+    if (m_units[unit].target != request.target)
     {
-      break;
+      ++misses;
+      continue;
+    }
+
+    request.unit = unit;
+    reserved[unit] = true;
+    touch(unit);
+
+    if (m_units[unit].samplerId != request.samplerId)
+    {
+      m_units[unit].samplerId = request.samplerId;
+      dirty.push_back(unit);
     }
   }
 
-  bind(unit, target, textureId, samplerId);
+  assert(misses <= static_cast<size_t>(std::count_if(m_lru.begin(), m_lru.end(), [&](size_t unit) {
+    return !m_units[unit].pinned && !reserved[unit];
+  })));
 
-  return unit;
+  for (Request &request : requests)
+  {
+    if (request.unit != INVALID_UNIT)
+      continue;
+
+    // Requested twice in the batch.
+    if (isBinded(request.textureId) && getTargetBinding(request.textureId) == request.target)
+    {
+      request.unit = getUnitBinding(request.textureId);
+      continue;
+    }
+
+    size_t unit = evict(reserved);
+
+    record(unit, request.target, request.textureId, request.samplerId);
+    touch(unit);
+
+    request.unit = unit;
+    reserved[unit] = true;
+    dirty.push_back(unit);
+  }
+
+  if (dirty.empty())
+    return;
+
+  std::sort(dirty.begin(), dirty.end());
+
+  std::vector<GLuint> textures;
+  std::vector<GLuint> samplers;
+
+  for (size_t i = 0; i < dirty.size(); ++i)
+  {
+    size_t unit = dirty[i];
+    const Unit &binding = m_units[unit];
+
+    // glBindTextures only accepts textures binded once.
+    if (!IndexedBindingBatch::hasMultiBind() || m_created.find(binding.textureId) == m_created.end())
+    {
+      setActiveUnit(unit);
+      glBindTexture(binding.target, binding.textureId);
+      glBindSampler(unit, binding.samplerId);
+      m_created.insert(binding.textureId);
+      continue;
+    }
+
+    textures.push_back(binding.textureId);
+    samplers.push_back(binding.samplerId);
+
+    // One call per run of consecutive units.
+    bool last = (i + 1 == dirty.size()) || (dirty[i + 1] != unit + 1)
+      || m_created.find(m_units[dirty[i + 1]].textureId) == m_created.end();
+
+    if (last)
+    {
+      size_t first = unit + 1 - textures.size();
+
+      glBindTextures(first, textures.size(), textures.data());
+      glBindSamplers(first, samplers.size(), samplers.data());
+
+      textures.clear();
+      samplers.clear();
+    }
+  }
 }
 
 void TextureUnitManager::unbind(GLuint textureId)
@@ -79,16 +259,51 @@ void TextureUnitManager::unbind(GLuint textureId)
   assert(isBinded(textureId));
 
   size_t unit = getUnitBinding(textureId);
-  GLenum target = getTargetBinding(textureId);
+  m_units[unit].pinned = false;
 
-  m_unitUsage.erase(unit);
-  m_unitBinding.erase(textureId);
+  if (m_lruPosition[unit] != m_lru.end())
+    m_lru.splice(m_lru.begin(), m_lru, m_lruPosition[unit]);
 }
 
 void TextureUnitManager::unbindAll()
 {
-  m_unitUsage.clear();
-  m_unitBinding.clear();
+  for (Unit &unit : m_units)
+  {
+    unit.pinned = false;
+  }
+}
+
+void TextureUnitManager::release(GLuint textureId)
+{
+  // The name may be reused by a new texture.
+  m_created.erase(textureId);
+
+  if (!isBinded(textureId))
+    return;
+
+  // Deleting a texture unbinds it from its unit.
+  size_t unit = getUnitBinding(textureId);
+  m_units[unit].textureId = 0;
+  m_units[unit].target = GL_NONE;
+  m_units[unit].pinned = false;
+  m_residency.erase(textureId);
+
+  if (m_lruPosition[unit] != m_lru.end())
+    m_lru.splice(m_lru.begin(), m_lru, m_lruPosition[unit]);
+}
+
+void TextureUnitManager::activate(GLuint textureId)
+{
+  setActiveUnit(getUnitBinding(textureId));
+}
+
+void TextureUnitManager::setActiveUnit(size_t unit)
+{
+  if (unit == m_activeUnit)
+    return;
+
+  glActiveTexture(GL_TEXTURE0 + unit);
+  m_activeUnit = unit;
 }
 
 //====================//
@@ -193,7 +408,42 @@ void Texture::setActiveTextureUnit(size_t unit)
 {
   assert(unit < getTextureUnitCount());
 
-  glActiveTexture(GL_TEXTURE0 + unit);
+  s_textureUnitManager.setActiveUnit(unit);
+}
+
+std::vector<size_t> Texture::bind(const std::vector<TargetPair> &textures)
+{
+  std::vector<TextureUnitManager::Request> requests;
+  requests.reserve(textures.size());
+
+  for (const TargetPair &texture : textures)
+  {
+    Sampler *sampler = texture.first->getSampler();
+
+    requests.push_back(TextureUnitManager::Request{
+      texture.second,
+      texture.first->getId(),
+      (sampler) ? sampler->getId() : 0,
+      0
+    });
+  }
+
+  s_textureUnitManager.bind(requests);
+
+  for (const TargetPair &texture : textures)
+  {
+    texture.first->initializeShadows(texture.second);
+  }
+
+  std::vector<size_t> units;
+  units.reserve(requests.size());
+
+  for (const TextureUnitManager::Request &request : requests)
+  {
+    units.push_back(request.unit);
+  }
+
+  return units;
 }
 
 TextureUnitManager Texture::s_textureUnitManager;
@@ -209,13 +459,139 @@ const ImageUnitManager& Texture::getImageUnitManager()
   return s_imageUnitManager;
 }
 
-Texture::Texture() : m_sampler(nullptr)
+size_t Texture::getMipmapLevelCount(size_t width, size_t height, size_t depth)
+{
+  size_t size = std::max(std::max(width, height), depth);
+  size_t levels = 1;
+
+  while (size > 1)
+  {
+    size >>= 1;
+    ++levels;
+  }
+
+  return levels;
+}
+
+bool Texture::hasGetTextureSubImage()
+{
+  static const bool getTextureSubImage = ContextInfo::version() >= Version(4, 5)
+    || ExtensionRegister::isAvaible(GLextension::GL_ARB_get_texture_sub_image);
+
+  return getTextureSubImage;
+}
+
+bool Texture::hasClearTexture()
+{
+  static const bool clearTexture = ContextInfo::version() >= Version(4, 4)
+    || ExtensionRegister::isAvaible(GLextension::GL_ARB_clear_texture);
+
+  return clearTexture;
+}
+
+const std::vector<GLenum>& Texture::getCompressedFormats()
+{
+  static std::vector<GLenum> formats;
+
+  if (formats.empty())
+  {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+
+    std::vector<GLint> values(count);
+
+    if (count > 0)
+      glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, values.data());
+
+    for (GLint value : values)
+      formats.push_back(static_cast<GLenum>(value));
+  }
+
+  return formats;
+}
+
+bool Texture::hasInternalFormatQuery()
+{
+  static const bool internalFormatQuery = ContextInfo::version() >= Version(4, 3)
+    || ExtensionRegister::isAvaible(GLextension::GL_ARB_internalformat_query2);
+
+  return internalFormatQuery;
+}
+
+bool Texture::isCompressedFormatSupported(GLenum internalFormat, GLenum target)
+{
+  if (hasInternalFormatQuery())
+  {
+    GLint supported = static_cast<GLint>(GL_FALSE);
+    glGetInternalformativ(target, internalFormat, GL_INTERNALFORMAT_SUPPORTED, 1, &supported);
+
+    return supported == static_cast<GLint>(GL_TRUE);
+  }
+
+  // GL_COMPRESSED_TEXTURE_FORMATS only lists general purpose formats, the
+  // block compression families are checked by version and extension.
+  switch (internalFormat)
+  {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+      return ExtensionRegister::isAvaible(GLextension::GL_EXT_texture_compression_s3tc);
+
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+      return ExtensionRegister::isAvaible(GLextension::GL_EXT_texture_compression_s3tc)
+        && ExtensionRegister::isAvaible(GLextension::GL_EXT_texture_sRGB);
+
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_SIGNED_RED_RGTC1:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_SIGNED_RG_RGTC2:
+      return ContextInfo::version() >= Version(3, 0)
+        || ExtensionRegister::isAvaible(GLextension::GL_ARB_texture_compression_rgtc);
+
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+    case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+      return ContextInfo::version() >= Version(4, 2)
+        || ExtensionRegister::isAvaible(GLextension::GL_ARB_texture_compression_bptc);
+
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_SRGB8_ETC2:
+    case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+    case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+    case GL_COMPRESSED_R11_EAC:
+    case GL_COMPRESSED_SIGNED_R11_EAC:
+    case GL_COMPRESSED_RG11_EAC:
+    case GL_COMPRESSED_SIGNED_RG11_EAC:
+      return ContextInfo::version() >= Version(4, 3)
+        || ExtensionRegister::isAvaible(GLextension::GL_ARB_ES3_compatibility);
+
+    default:
+    {
+      const std::vector<GLenum> &formats = getCompressedFormats();
+      return std::find(formats.begin(), formats.end(), internalFormat) != formats.end();
+    }
+  }
+}
+
+Texture::Texture()
+: m_sampler(nullptr), m_immutable(false), m_storageFormat(GL_NONE)
 {
   glGenTextures(1, &m_id);
 }
 
 Texture::~Texture()
 {
+  // Frees the unit, the manager would keep the deleted id.
+  s_textureUnitManager.release(m_id);
+
+  MemoryRegistry::remove(this);
   glDeleteTextures(1, &m_id);
 }
 
@@ -227,6 +603,10 @@ bool Texture::isBinded() const
 GLenum Texture::getTarget() const
 {
   assert(isBinded());
+
+  // Target based calls act on the active unit.
+  s_textureUnitManager.activate(m_id);
+
   return s_textureUnitManager.getTargetBinding(m_id);
 }
 
@@ -237,11 +617,15 @@ GLenum Texture::getTarget() const
 void Texture::bind(size_t unit, GLenum target)
 {
   s_textureUnitManager.bind(unit, target, m_id, (m_sampler) ? m_sampler->getId() : 0);
+  initializeShadows(target);
 }
 
 size_t Texture::bind(GLenum target)
 {
-  return s_textureUnitManager.bind(target, m_id, (m_sampler) ? m_sampler->getId() : 0);
+  size_t unit = s_textureUnitManager.bind(target, m_id, (m_sampler) ? m_sampler->getId() : 0);
+  initializeShadows(target);
+
+  return unit;
 }
 
 void Texture::unbind()
@@ -273,6 +657,50 @@ void Texture::getData(size_t level, GLenum format, GLenum type, void *img) const
   glGetTexImage(getTarget(), level, format, type, img);
 }
 
+void Texture::readAsync(
+  Readback &readback,
+  size_t level,
+  size_t x, size_t y, size_t z,
+  size_t width, size_t height, size_t depth,
+  GLenum format,
+  GLenum type
+) const
+{
+  size_t alignment = get<GL_PACK_ALIGNMENT, GLint>();
+  size_t rowSize = width * getPixelSize(format, type);
+  size_t size = (rowSize + alignment - 1) / alignment * alignment * height * depth;
+
+  assert(size <= readback.getCapacity());
+
+  // With a PIXEL_PACK buffer binded, the data pointer is an offset.
+  Buffer &buffer = readback.getBuffer();
+  buffer.bind(GL_PIXEL_PACK_BUFFER);
+
+  if (hasGetTextureSubImage())
+  {
+    glGetTextureSubImage(
+      m_id,
+      level,
+      x, y, z,
+      width, height, depth,
+      format,
+      type,
+      size,
+      nullptr
+    );
+  }
+  else
+  {
+    assert(x == 0 && y == 0 && z == 0);
+    assert(width == getWidth(level) && height == getHeight(level) && depth == getDepth(level));
+
+    glGetTexImage(getTarget(), level, format, type, nullptr);
+  }
+
+  buffer.unbind();
+  readback.fence(size);
+}
+
 void Texture::setData(
   size_t level,
   gl::GLenum format,
@@ -283,6 +711,14 @@ void Texture::setData(
 )
 {
   assert(isBinded());
+
+  if (m_immutable)
+  {
+    assert(internalFormat == m_storageFormat);
+    setSubData(level, 0, size, format, type, data);
+    return;
+  }
+
   glTexImage1D(
     getTarget(),
     level,
@@ -293,6 +729,8 @@ void Texture::setData(
     type,
     data
   );
+  setLevelSize(level, getImageSize(internalFormat, size));
+  setLevelState(level, internalFormat, size, 1, 1);
 }
 
 void Texture::setData(
@@ -305,6 +743,14 @@ void Texture::setData(
 )
 {
   assert(isBinded());
+
+  if (m_immutable)
+  {
+    assert(internalFormat == m_storageFormat);
+    setSubData(level, 0, 0, width, height, format, type, data);
+    return;
+  }
+
   glTexImage2D(
     getTarget(),
     level,
@@ -315,6 +761,8 @@ void Texture::setData(
     type,
     data
   );
+  setLevelSize(level, getImageSize(internalFormat, width, height));
+  setLevelState(level, internalFormat, width, height, 1);
 }
 
 void Texture::setData(
@@ -327,6 +775,14 @@ void Texture::setData(
 )
 {
   assert(isBinded());
+
+  if (m_immutable)
+  {
+    assert(internalFormat == m_storageFormat);
+    setSubData(level, 0, 0, 0, width, height, depth, format, type, data);
+    return;
+  }
+
   glTexImage3D(
     getTarget(),
     level,
@@ -337,12 +793,338 @@ void Texture::setData(
     type,
     data
   );
+  setLevelSize(level, getImageSize(internalFormat, width, height, depth));
+  setLevelState(level, internalFormat, width, height, depth);
+}
+
+void Texture::setSubData(
+  size_t level,
+  size_t x,
+  size_t width,
+  GLenum format,
+  GLenum type,
+  const void *data
+)
+{
+  assert(isBinded());
+  glTexSubImage1D(getTarget(), level, x, width, format, type, data);
+}
+
+void Texture::setSubData(
+  size_t level,
+  size_t x, size_t y,
+  size_t width, size_t height,
+  GLenum format,
+  GLenum type,
+  const void *data
+)
+{
+  assert(isBinded());
+  glTexSubImage2D(getTarget(), level, x, y, width, height, format, type, data);
+}
+
+void Texture::setSubData(
+  size_t level,
+  size_t x, size_t y, size_t z,
+  size_t width, size_t height, size_t depth,
+  GLenum format,
+  GLenum type,
+  const void *data
+)
+{
+  assert(isBinded());
+  glTexSubImage3D(getTarget(), level, x, y, z, width, height, depth, format, type, data);
+}
+
+void Texture::setCompressedData(
+  size_t level,
+  GLenum internalFormat,
+  size_t width,
+  size_t size,
+  const void *data
+)
+{
+  assert(isBinded());
+  assert(isCompressedFormat(internalFormat));
+
+  if (m_immutable)
+  {
+    setCompressedSubData(level, 0, width, internalFormat, size, data);
+    return;
+  }
+
+  glCompressedTexImage1D(getTarget(), level, internalFormat, width, 0, size, data);
+  setLevelSize(level, size);
+  setLevelState(level, internalFormat, width, 1, 1);
+}
+
+void Texture::setCompressedData(
+  size_t level,
+  GLenum internalFormat,
+  size_t width, size_t height,
+  size_t size,
+  const void *data
+)
+{
+  assert(isBinded());
+  assert(isCompressedFormat(internalFormat));
+
+  if (m_immutable)
+  {
+    setCompressedSubData(level, 0, 0, width, height, internalFormat, size, data);
+    return;
+  }
+
+  glCompressedTexImage2D(getTarget(), level, internalFormat, width, height, 0, size, data);
+  setLevelSize(level, size);
+  setLevelState(level, internalFormat, width, height, 1);
+}
+
+void Texture::setCompressedData(
+  size_t level,
+  GLenum internalFormat,
+  size_t width, size_t height, size_t depth,
+  size_t size,
+  const void *data
+)
+{
+  assert(isBinded());
+  assert(isCompressedFormat(internalFormat));
+
+  if (m_immutable)
+  {
+    setCompressedSubData(level, 0, 0, 0, width, height, depth, internalFormat, size, data);
+    return;
+  }
+
+  glCompressedTexImage3D(getTarget(), level, internalFormat, width, height, depth, 0, size, data);
+  setLevelSize(level, size);
+  setLevelState(level, internalFormat, width, height, depth);
+}
+
+void Texture::setCompressedSubData(
+  size_t level,
+  size_t x,
+  size_t width,
+  GLenum internalFormat,
+  size_t size,
+  const void *data
+)
+{
+  assert(isBinded());
+  glCompressedTexSubImage1D(getTarget(), level, x, width, internalFormat, size, data);
+}
+
+void Texture::setCompressedSubData(
+  size_t level,
+  size_t x, size_t y,
+  size_t width, size_t height,
+  GLenum internalFormat,
+  size_t size,
+  const void *data
+)
+{
+  assert(isBinded());
+  glCompressedTexSubImage2D(getTarget(), level, x, y, width, height, internalFormat, size, data);
+}
+
+void Texture::setCompressedSubData(
+  size_t level,
+  size_t x, size_t y, size_t z,
+  size_t width, size_t height, size_t depth,
+  GLenum internalFormat,
+  size_t size,
+  const void *data
+)
+{
+  assert(isBinded());
+
+  GLenum target = getTarget();
+
+  if (target != GL_TEXTURE_CUBE_MAP)
+  {
+    glCompressedTexSubImage3D(target, level, x, y, z, width, height, depth, internalFormat, size, data);
+    return;
+  }
+
+  // Cube map faces are separate 2D targets, laid out one after the other.
+  // data may be an offset in the pixel unpack buffer, null included.
+  assert(z + depth <= 6);
+
+  size_t faceSize = size / depth;
+  const unsigned char *face = static_cast<const unsigned char*>(data);
+
+  for (size_t i = 0; i < depth; ++i)
+  {
+    glCompressedTexSubImage2D(
+      static_cast<GLenum>(static_cast<unsigned int>(GL_TEXTURE_CUBE_MAP_POSITIVE_X) + z + i),
+      level,
+      x, y,
+      width, height,
+      internalFormat,
+      faceSize,
+      face + i * faceSize
+    );
+  }
+}
+
+void Texture::allocateStorage(size_t levels, GLenum internalFormat, size_t width)
+{
+  assert(isBinded());
+  assert(!m_immutable);
+
+  if (levels == 0)
+    levels = getMipmapLevelCount(width);
+
+  glTexStorage1D(getTarget(), levels, internalFormat, width);
+
+  m_immutable = true;
+  m_storageFormat = internalFormat;
+  setStorageLevels(levels, width, 1, 1, false, false);
+}
+
+void Texture::allocateStorage(
+  size_t levels,
+  GLenum internalFormat,
+  size_t width, size_t height
+)
+{
+  assert(isBinded());
+  assert(!m_immutable);
+
+  bool layered = (getTarget() == GL_TEXTURE_1D_ARRAY);
+
+  if (levels == 0)
+    levels = getMipmapLevelCount(width, layered ? 1 : height);
+
+  glTexStorage2D(getTarget(), levels, internalFormat, width, height);
+
+  m_immutable = true;
+  m_storageFormat = internalFormat;
+
+  // Cube maps allocate 6 faces.
+  size_t faces = (getTarget() == GL_TEXTURE_CUBE_MAP) ? 6 : 1;
+  setStorageLevels(levels, width, height, 1, layered, false, faces);
+}
+
+void Texture::allocateStorage(
+  size_t levels,
+  GLenum internalFormat,
+  size_t width, size_t height, size_t depth
+)
+{
+  assert(isBinded());
+  assert(!m_immutable);
+
+  GLenum target = getTarget();
+  bool layered = (target == GL_TEXTURE_2D_ARRAY || target == GL_TEXTURE_CUBE_MAP_ARRAY);
+
+  if (levels == 0)
+    levels = getMipmapLevelCount(width, height, layered ? 1 : depth);
+
+  glTexStorage3D(target, levels, internalFormat, width, height, depth);
+
+  m_immutable = true;
+  m_storageFormat = internalFormat;
+  setStorageLevels(levels, width, height, depth, false, layered);
 }
 
 void Texture::generateMipmaps()
 {
   assert(isBinded());
-  glGenerateMipmap(getTarget());
+
+  GLenum target = getTarget();
+  glGenerateMipmap(target);
+
+  // Immutable levels are already known.
+  const LevelState *base = getLevelState(getBaseLevel());
+
+  if (m_immutable || !base)
+    return;
+
+  bool layeredHeight = (target == GL_TEXTURE_1D_ARRAY);
+  bool layeredDepth = (target == GL_TEXTURE_2D_ARRAY || target == GL_TEXTURE_CUBE_MAP_ARRAY);
+  LevelState state = *base;
+
+  size_t levels = getMipmapLevelCount(
+    state.width,
+    layeredHeight ? 1 : state.height,
+    layeredDepth ? 1 : state.depth
+  );
+
+  size_t maxLevel = std::min<size_t>(getMaxLevel(), getBaseLevel() + levels - 1);
+
+  for (size_t level = getBaseLevel() + 1; level <= maxLevel; ++level)
+  {
+    state.width = std::max<size_t>(state.width >> 1, 1);
+    state.height = layeredHeight ? state.height : std::max<size_t>(state.height >> 1, 1);
+    state.depth = layeredDepth ? state.depth : std::max<size_t>(state.depth >> 1, 1);
+
+    size_t faces = (target == GL_TEXTURE_CUBE_MAP) ? 6 : 1;
+
+    setLevelSize(level, getImageSize(state.internalFormat, state.width, state.height, state.depth * faces));
+    setLevelState(level, state.internalFormat, state.width, state.height, state.depth);
+  }
+}
+
+void Texture::setLevelSize(size_t level, size_t size)
+{
+  if (level >= m_levelSizes.size())
+    m_levelSizes.resize(level + 1, 0);
+
+  m_levelSizes[level] = size;
+
+  size_t total = 0;
+  for (size_t levelSize : m_levelSizes)
+  {
+    total += levelSize;
+  }
+
+  MemoryRegistry::update(MemoryRegistry::Category::TEXTURE, this, total);
+}
+
+const Texture::LevelState* Texture::getLevelState(size_t level) const
+{
+  if (level >= m_levelStates.size() || m_levelStates[level].internalFormat == GL_NONE)
+    return nullptr;
+
+  return &m_levelStates[level];
+}
+
+void Texture::setLevelState(
+  size_t level,
+  GLenum internalFormat,
+  size_t width, size_t height, size_t depth
+)
+{
+  if (level >= m_levelStates.size())
+    m_levelStates.resize(level + 1, LevelState{0, 0, 0, GL_NONE, false});
+
+  // Unsized formats are resolved by the driver, queried at first use.
+  bool sized = (getSizedFormat(internalFormat) == internalFormat && getFormatBits(internalFormat) != 0);
+  m_levelStates[level] = LevelState{width, height, depth, internalFormat, sized};
+}
+
+void Texture::setStorageLevels(
+  size_t levels,
+  size_t width, size_t height, size_t depth,
+  bool layeredHeight, bool layeredDepth,
+  size_t faces
+)
+{
+  m_levelSizes.assign(levels, 0);
+
+  for (size_t level = 0; level < levels; ++level)
+  {
+    size_t levelWidth = std::max<size_t>(width >> level, 1);
+    size_t levelHeight = layeredHeight ? height : std::max<size_t>(height >> level, 1);
+    size_t levelDepth = layeredDepth ? depth : std::max<size_t>(depth >> level, 1);
+
+    m_levelSizes[level] = getImageSize(m_storageFormat, levelWidth, levelHeight, levelDepth * faces);
+    setLevelState(level, m_storageFormat, levelWidth, levelHeight, levelDepth);
+  }
+
+  setLevelSize(0, m_levelSizes[0]);
 }
 
 //====================//
@@ -377,19 +1159,16 @@ namespace
     *value = static_cast<GLenum>(uvalue);
   }
 
-  template <GLenum PARAMETER, typename T>
-  inline T getParameter(GLenum target)
+  inline void _getParameter(GLenum target, GLenum parameter, std::array<GLfloat, 4> *value)
   {
-    T value;
-    _getParameter(target, PARAMETER, &value);
-    return value;
+    glGetTexParameterfv(target, parameter, value->data());
   }
 
   template <GLenum PARAMETER, typename T>
-  inline T getParameterv(GLenum target)
+  inline T getParameter(GLenum target)
   {
     T value;
-    _getParameter(target, PARAMETER, value.data());
+    _getParameter(target, PARAMETER, &value);
     return value;
   }
 }
@@ -421,17 +1200,73 @@ namespace
     glTexParameterIuiv(target, parameter, &uvalue);
   }
 
+  inline void _setParameter(GLenum target, GLenum parameter, const std::array<GLfloat, 4> *value)
+  {
+    glTexParameterfv(target, parameter, value->data());
+  }
+
   template <GLenum PARAMETER, typename T>
   inline void setParameter(GLenum target, const T &value)
   {
     _setParameter(target, PARAMETER, &value);
   }
+}
 
-  template <GLenum PARAMETER, typename T>
-  inline void setParameterv(GLenum target, const T &value)
+void Texture::initializeShadows(GLenum target)
+{
+  if (m_baseLevel.known)
+    return;
+
+  // Rectangle textures have no mipmaps, they default to clamping.
+  bool rectangle = (target == GL_TEXTURE_RECTANGLE);
+  GLenum wrap = rectangle ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+
+  m_baseLevel.reset(0);
+  m_maxLevel.reset(1000);
+  m_swizzleR.reset(GL_RED);
+  m_swizzleG.reset(GL_GREEN);
+  m_swizzleB.reset(GL_BLUE);
+  m_swizzleA.reset(GL_ALPHA);
+  m_magFilter.reset(GL_LINEAR);
+  m_minFilter.reset(rectangle ? GL_LINEAR : GL_NEAREST_MIPMAP_LINEAR);
+  // Integer queries of the LOD bounds, as glGetTexParameteriv reports them.
+  m_minLOD.reset(static_cast<GLuint>(-1000));
+  m_maxLOD.reset(1000);
+  m_wrapS.reset(wrap);
+  m_wrapT.reset(wrap);
+  m_wrapR.reset(wrap);
+  m_borderColor.reset(Color{{0.0f, 0.0f, 0.0f, 0.0f}});
+  m_compareFunction.reset(GL_LEQUAL);
+}
+
+template <GLenum PARAMETER, typename T>
+T Texture::getShadowed(Shadowed<T> &shadow) const
+{
+  if (!shadow.known)
   {
-    _setParameter(target, PARAMETER, value.data());
+    shadow.value = getParameter<PARAMETER, T>(getTarget());
+    shadow.known = true;
   }
+
+  return shadow.value;
+}
+
+template <GLenum PARAMETER, typename T>
+void Texture::setShadowed(Shadowed<T> &shadow, const T &value)
+{
+  if (shadow.known && shadow.value == value)
+    return;
+
+  setParameter<PARAMETER, T>(getTarget(), value);
+  shadow.value = value;
+  shadow.known = true;
+}
+
+template <GLenum PARAMETER, typename T>
+void Texture::copyShadowed(Shadowed<T> &shadow, const Shadowed<T> &source)
+{
+  if (source.known)
+    setShadowed<PARAMETER>(shadow, source.value);
 }
 
 //-----------------------------//
@@ -443,37 +1278,37 @@ namespace
 size_t Texture::getBaseLevel() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_BASE_LEVEL, GLuint>(getTarget());
+  return getShadowed<GL_TEXTURE_BASE_LEVEL>(m_baseLevel);
 }
 
 size_t Texture::getMaxLevel() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_MAX_LEVEL, GLuint>(getTarget());
+  return getShadowed<GL_TEXTURE_MAX_LEVEL>(m_maxLevel);
 }
 
 GLenum Texture::getSwizzleR() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_SWIZZLE_R, GLenum>(getTarget());
+  return getShadowed<GL_TEXTURE_SWIZZLE_R>(m_swizzleR);
 }
 
 GLenum Texture::getSwizzleG() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_SWIZZLE_G, GLenum>(getTarget());
+  return getShadowed<GL_TEXTURE_SWIZZLE_G>(m_swizzleG);
 }
 
 GLenum Texture::getSwizzleB() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_SWIZZLE_B, GLenum>(getTarget());
+  return getShadowed<GL_TEXTURE_SWIZZLE_B>(m_swizzleB);
 }
 
 GLenum Texture::getSwizzleA() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_SWIZZLE_A, GLenum>(getTarget());
+  return getShadowed<GL_TEXTURE_SWIZZLE_A>(m_swizzleA);
 }
 
 // TODO: DEPTH_STENCIL_TEXTURE_MODE
@@ -481,37 +1316,37 @@ GLenum Texture::getSwizzleA() const
 void Texture::setBaseLevel(size_t value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_BASE_LEVEL, GLuint>(getTarget(), value);
+  setShadowed<GL_TEXTURE_BASE_LEVEL>(m_baseLevel, static_cast<GLuint>(value));
 }
 
 void Texture::setMaxLevel(size_t value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_MAX_LEVEL, GLuint>(getTarget(), value);
+  setShadowed<GL_TEXTURE_MAX_LEVEL>(m_maxLevel, static_cast<GLuint>(value));
 }
 
 void Texture::setSwizzleR(GLenum value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_SWIZZLE_R, GLenum>(getTarget(), value);
+  setShadowed<GL_TEXTURE_SWIZZLE_R>(m_swizzleR, value);
 }
 
 void Texture::setSwizzleG(GLenum value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_SWIZZLE_G, GLenum>(getTarget(), value);
+  setShadowed<GL_TEXTURE_SWIZZLE_G>(m_swizzleG, value);
 }
 
 void Texture::setSwizzleB(GLenum value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_SWIZZLE_B, GLenum>(getTarget(), value);
+  setShadowed<GL_TEXTURE_SWIZZLE_B>(m_swizzleB, value);
 }
 
 void Texture::setSwizzleA(GLenum value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_SWIZZLE_A, GLenum>(getTarget(), value);
+  setShadowed<GL_TEXTURE_SWIZZLE_A>(m_swizzleA, value);
 }
 
 //---------------------------//
@@ -521,49 +1356,50 @@ void Texture::setSwizzleA(GLenum value)
 GLenum Texture::getMagFilter() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_MAG_FILTER, GLenum>(getTarget());
+  return getShadowed<GL_TEXTURE_MAG_FILTER>(m_magFilter);
 }
 
 GLenum Texture::getMinFilter() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_MIN_FILTER, GLenum>(getTarget());
+  return getShadowed<GL_TEXTURE_MIN_FILTER>(m_minFilter);
 }
 
 size_t Texture::getMinLOD() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_MIN_LOD, GLuint>(getTarget());
+  return getShadowed<GL_TEXTURE_MIN_LOD>(m_minLOD);
 }
 
 size_t Texture::getMaxLOD() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_MAX_LOD, GLuint>(getTarget());
+  return getShadowed<GL_TEXTURE_MAX_LOD>(m_maxLOD);
 }
 
 GLenum Texture::getWrapS() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_WRAP_S, GLenum>(getTarget());
+  return getShadowed<GL_TEXTURE_WRAP_S>(m_wrapS);
 }
 
 GLenum Texture::getWrapT() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_WRAP_T, GLenum>(getTarget());
+  return getShadowed<GL_TEXTURE_WRAP_T>(m_wrapT);
 }
 
 GLenum Texture::getWrapR() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_WRAP_R, GLenum>(getTarget());
+  return getShadowed<GL_TEXTURE_WRAP_R>(m_wrapR);
 }
 
 Vector4 Texture::getBorderColor() const
 {
   assert(isBinded());
-  return getParameterv<GL_TEXTURE_BORDER_COLOR, Vector4>(getTarget());
+  Color color = getShadowed<GL_TEXTURE_BORDER_COLOR>(m_borderColor);
+  return Vector4(color[0], color[1], color[2], color[3]);
 }
 
 // TODO: TEXTURE_COMPARE_MODE
@@ -571,76 +1407,76 @@ Vector4 Texture::getBorderColor() const
 GLenum Texture::getCompareFunction() const
 {
   assert(isBinded());
-  return getParameter<GL_TEXTURE_COMPARE_FUNC, GLenum>(getTarget());
+  return getShadowed<GL_TEXTURE_COMPARE_FUNC>(m_compareFunction);
 }
 
 void Texture::setMagFilter(GLenum value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_MAG_FILTER, GLenum>(getTarget(), value);
+  setShadowed<GL_TEXTURE_MAG_FILTER>(m_magFilter, value);
 }
 
 void Texture::setMinFilter(GLenum value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_MIN_FILTER, GLenum>(getTarget(), value);
+  setShadowed<GL_TEXTURE_MIN_FILTER>(m_minFilter, value);
 }
 
 void Texture::setMinLOD(size_t value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_MIN_LOD, GLuint>(getTarget(), value);
+  setShadowed<GL_TEXTURE_MIN_LOD>(m_minLOD, static_cast<GLuint>(value));
 }
 
 void Texture::setMaxLOD(size_t value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_MAX_LOD, GLuint>(getTarget(), value);
+  setShadowed<GL_TEXTURE_MAX_LOD>(m_maxLOD, static_cast<GLuint>(value));
 }
 
 void Texture::setWrapS(GLenum value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_WRAP_S, GLenum>(getTarget(), value);
+  setShadowed<GL_TEXTURE_WRAP_S>(m_wrapS, value);
 }
 
 void Texture::setWrapT(GLenum value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_WRAP_T, GLenum>(getTarget(), value);
+  setShadowed<GL_TEXTURE_WRAP_T>(m_wrapT, value);
 }
 
 void Texture::setWrapR(GLenum value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_WRAP_R, GLenum>(getTarget(), value);
+  setShadowed<GL_TEXTURE_WRAP_R>(m_wrapR, value);
 }
 
 void Texture::setWrap(GLenum s)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_WRAP_S, GLenum>(getTarget(), s);
+  setShadowed<GL_TEXTURE_WRAP_S>(m_wrapS, s);
 }
 
 void Texture::setWrap(GLenum s, GLenum t)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_WRAP_S, GLenum>(getTarget(), s);
-  setParameter<GL_TEXTURE_WRAP_T, GLenum>(getTarget(), t);
+  setShadowed<GL_TEXTURE_WRAP_S>(m_wrapS, s);
+  setShadowed<GL_TEXTURE_WRAP_T>(m_wrapT, t);
 }
 
 void Texture::setWrap(GLenum s, GLenum t, GLenum r)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_WRAP_S, GLenum>(getTarget(), s);
-  setParameter<GL_TEXTURE_WRAP_T, GLenum>(getTarget(), t);
-  setParameter<GL_TEXTURE_WRAP_R, GLenum>(getTarget(), r);
+  setShadowed<GL_TEXTURE_WRAP_S>(m_wrapS, s);
+  setShadowed<GL_TEXTURE_WRAP_T>(m_wrapT, t);
+  setShadowed<GL_TEXTURE_WRAP_R>(m_wrapR, r);
 }
 
 void Texture::setBorderColor(const Vector4 &value)
 {
   assert(isBinded());
-  setParameterv<GL_TEXTURE_BORDER_COLOR, Vector4>(getTarget(), value);
+  setShadowed<GL_TEXTURE_BORDER_COLOR>(m_borderColor, Color{{value[0], value[1], value[2], value[3]}});
 }
 
 // TODO: TEXTURE_COMPARE_MODE
@@ -648,7 +1484,30 @@ void Texture::setBorderColor(const Vector4 &value)
 void Texture::setCompareFunction(GLenum value)
 {
   assert(isBinded());
-  setParameter<GL_TEXTURE_COMPARE_FUNC, GLenum>(getTarget(), value);
+  setShadowed<GL_TEXTURE_COMPARE_FUNC>(m_compareFunction, value);
+}
+
+void Texture::copyParameters(const Texture &source)
+{
+  assert(isBinded());
+
+  copyShadowed<GL_TEXTURE_BASE_LEVEL>(m_baseLevel, source.m_baseLevel);
+  copyShadowed<GL_TEXTURE_MAX_LEVEL>(m_maxLevel, source.m_maxLevel);
+  copyShadowed<GL_TEXTURE_SWIZZLE_R>(m_swizzleR, source.m_swizzleR);
+  copyShadowed<GL_TEXTURE_SWIZZLE_G>(m_swizzleG, source.m_swizzleG);
+  copyShadowed<GL_TEXTURE_SWIZZLE_B>(m_swizzleB, source.m_swizzleB);
+  copyShadowed<GL_TEXTURE_SWIZZLE_A>(m_swizzleA, source.m_swizzleA);
+  copyShadowed<GL_TEXTURE_MAG_FILTER>(m_magFilter, source.m_magFilter);
+  copyShadowed<GL_TEXTURE_MIN_FILTER>(m_minFilter, source.m_minFilter);
+  copyShadowed<GL_TEXTURE_MIN_LOD>(m_minLOD, source.m_minLOD);
+  copyShadowed<GL_TEXTURE_MAX_LOD>(m_maxLOD, source.m_maxLOD);
+  copyShadowed<GL_TEXTURE_WRAP_S>(m_wrapS, source.m_wrapS);
+  copyShadowed<GL_TEXTURE_WRAP_T>(m_wrapT, source.m_wrapT);
+  copyShadowed<GL_TEXTURE_WRAP_R>(m_wrapR, source.m_wrapR);
+  copyShadowed<GL_TEXTURE_BORDER_COLOR>(m_borderColor, source.m_borderColor);
+  copyShadowed<GL_TEXTURE_COMPARE_FUNC>(m_compareFunction, source.m_compareFunction);
+
+  m_sampler = source.m_sampler;
 }
 
 //==========================//
@@ -715,18 +1574,33 @@ namespace
 
 size_t Texture::getWidth(size_t level) const
 {
+  const LevelState *state = getLevelState(level);
+
+  if (state)
+    return state->width;
+
   assert(isBinded());
   return getLevelParameter<GL_TEXTURE_WIDTH, GLint>(getTarget(), level);
 }
 
 size_t Texture::getHeight(size_t level) const
 {
+  const LevelState *state = getLevelState(level);
+
+  if (state)
+    return state->height;
+
   assert(isBinded());
   return getLevelParameter<GL_TEXTURE_HEIGHT, GLint>(getTarget(), level);
 }
 
 size_t Texture::getDepth(size_t level) const
 {
+  const LevelState *state = getLevelState(level);
+
+  if (state)
+    return state->depth;
+
   assert(isBinded());
   return getLevelParameter<GL_TEXTURE_DEPTH, GLint>(getTarget(), level);
 }
@@ -745,14 +1619,32 @@ bool Texture::getFixedSampleLocations(size_t level) const
 
 gl::GLenum Texture::getInternalFormat(size_t level) const
 {
+  const LevelState *state = getLevelState(level);
+
+  if (state && state->sized)
+    return state->internalFormat;
+
   assert(isBinded());
-  return getLevelParameter<GL_TEXTURE_INTERNAL_FORMAT, GLenum>(getTarget(), level);
+  GLenum internalFormat = getLevelParameter<GL_TEXTURE_INTERNAL_FORMAT, GLenum>(getTarget(), level);
+
+  if (state)
+  {
+    m_levelStates[level].internalFormat = internalFormat;
+    m_levelStates[level].sized = true;
+  }
+
+  return internalFormat;
 }
 
 // TODO: GL_TEXTURE_SHARED_SIZE
 
 bool Texture::getCompressed(size_t level) const
 {
+  const LevelState *state = getLevelState(level);
+
+  if (state && state->sized)
+    return isCompressedFormat(state->internalFormat);
+
   assert(isBinded());
   return getLevelParameter<GL_TEXTURE_COMPRESSED, GLint>(getTarget(), level);
 }
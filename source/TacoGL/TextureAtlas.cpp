@@ -0,0 +1,375 @@
+#include <cassert>
+#include <algorithm>
+
+#include <TacoGL/TextureAtlas.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+//================//
+// Skyline Packer //
+//================//
+
+SkylinePacker::SkylinePacker(size_t width, size_t height)
+: m_width(width), m_height(height), m_usedArea(0), m_skyline()
+{
+  reset();
+}
+
+void SkylinePacker::reset()
+{
+  m_usedArea = 0;
+  m_skyline.assign(1, Segment{0, 0, m_width});
+}
+
+bool SkylinePacker::fit(size_t index, size_t width, size_t height, size_t &y) const
+{
+  if (m_skyline[index].x + width > m_width)
+    return false;
+
+  size_t remaining = width;
+  y = 0;
+
+  for (size_t i = index; remaining > 0; ++i)
+  {
+    assert(i < m_skyline.size());
+
+    y = std::max(y, m_skyline[i].y);
+
+    if (y + height > m_height)
+      return false;
+
+    remaining -= std::min(remaining, m_skyline[i].width);
+  }
+
+  return true;
+}
+
+bool SkylinePacker::pack(size_t width, size_t height, size_t &x, size_t &y)
+{
+  size_t best = m_skyline.size();
+  size_t bestTop = m_height + 1;
+  size_t bestWidth = 0;
+
+  for (size_t i = 0; i < m_skyline.size(); ++i)
+  {
+    size_t top;
+
+    if (!fit(i, width, height, top))
+      continue;
+
+    top += height;
+
+    // Lowest top first, then the narrowest segment.
+    if (top < bestTop || (top == bestTop && m_skyline[i].width < bestWidth))
+    {
+      best = i;
+      bestTop = top;
+      bestWidth = m_skyline[i].width;
+    }
+  }
+
+  if (best == m_skyline.size())
+    return false;
+
+  x = m_skyline[best].x;
+  y = bestTop - height;
+
+  // Raise the outline over the rectangle.
+  m_skyline.insert(m_skyline.begin() + best, Segment{x, bestTop, width});
+
+  for (size_t i = best + 1; i < m_skyline.size();)
+  {
+    const Segment &previous = m_skyline[i - 1];
+    Segment &segment = m_skyline[i];
+    size_t end = previous.x + previous.width;
+
+    if (segment.x >= end)
+      break;
+
+    size_t overlap = end - segment.x;
+
+    if (segment.width <= overlap)
+    {
+      m_skyline.erase(m_skyline.begin() + i);
+      continue;
+    }
+
+    segment.x += overlap;
+    segment.width -= overlap;
+    break;
+  }
+
+  // Merge the segments at the same height.
+  for (size_t i = 1; i < m_skyline.size();)
+  {
+    if (m_skyline[i - 1].y == m_skyline[i].y)
+    {
+      m_skyline[i - 1].width += m_skyline[i].width;
+      m_skyline.erase(m_skyline.begin() + i);
+    }
+    else
+    {
+      ++i;
+    }
+  }
+
+  m_usedArea += width * height;
+
+  return true;
+}
+
+//===============//
+// Texture Atlas //
+//===============//
+
+const TextureAtlas::Handle TextureAtlas::INVALID_HANDLE = static_cast<Handle>(-1);
+
+TextureAtlas::TextureAtlas(
+  GLenum internalFormat,
+  size_t width,
+  size_t height,
+  size_t layers,
+  size_t padding
+)
+: m_texture(nullptr),
+  m_internalFormat(internalFormat),
+  m_width(width),
+  m_height(height),
+  m_padding(padding),
+  m_packers(),
+  m_regions(),
+  m_nextHandle(0)
+{
+  assert(layers > 0);
+
+  m_texture = createTexture(layers);
+  m_packers.assign(layers, SkylinePacker(width, height));
+}
+
+TextureAtlas::~TextureAtlas()
+{
+  delete m_texture;
+}
+
+float TextureAtlas::getFragmentation() const
+{
+  size_t used = 0;
+  for (const SkylinePacker &packer : m_packers)
+  {
+    used += packer.getUsedArea();
+  }
+
+  size_t live = 0;
+  for (const auto &entry : m_regions)
+  {
+    live += (entry.second.width + m_padding) * (entry.second.height + m_padding);
+  }
+
+  return (used == 0) ? 0.f : 1.f - float(live) / float(used);
+}
+
+TextureAtlas::Handle TextureAtlas::add(size_t width, size_t height)
+{
+  assert(width + m_padding <= m_width && height + m_padding <= m_height);
+
+  Region region;
+
+  if (!pack(width, height, region))
+  {
+    grow(2 * m_packers.size());
+
+    bool packed = pack(width, height, region);
+    assert(packed);
+    (void) packed;
+  }
+
+  Handle handle = m_nextHandle++;
+  m_regions.emplace(handle, region);
+
+  return handle;
+}
+
+TextureAtlas::Handle TextureAtlas::add(
+  size_t width,
+  size_t height,
+  GLenum format,
+  GLenum type,
+  const void *data
+)
+{
+  Handle handle = add(width, height);
+  set(handle, format, type, data);
+
+  return handle;
+}
+
+void TextureAtlas::set(Handle handle, GLenum format, GLenum type, const void *data)
+{
+  const Region &region = getRegion(handle);
+
+  bool binding = !m_texture->isBinded();
+
+  if (binding)
+    m_texture->bind(GL_TEXTURE_2D_ARRAY);
+
+  m_texture->setSubData(
+    0,
+    region.x, region.y, region.layer,
+    region.width, region.height, 1,
+    format,
+    type,
+    data
+  );
+
+  // Zero the padding on the right and bottom, copied along with the image.
+  if (m_padding > 0 && Texture::hasClearTexture())
+  {
+    glClearTexSubImage(
+      m_texture->getId(), 0,
+      region.x + region.width, region.y, region.layer,
+      m_padding, region.height + m_padding, 1,
+      format, type, nullptr
+    );
+
+    glClearTexSubImage(
+      m_texture->getId(), 0,
+      region.x, region.y + region.height, region.layer,
+      region.width, m_padding, 1,
+      format, type, nullptr
+    );
+  }
+
+  if (binding)
+    m_texture->unbind();
+}
+
+void TextureAtlas::remove(Handle handle)
+{
+  assert(contains(handle));
+  m_regions.erase(handle);
+}
+
+const TextureAtlas::Region & TextureAtlas::getRegion(Handle handle) const
+{
+  assert(contains(handle));
+  return m_regions.at(handle);
+}
+
+Vector4 TextureAtlas::getCoordinates(Handle handle) const
+{
+  const Region &region = getRegion(handle);
+
+  return Vector4(
+    float(region.x) / m_width,
+    float(region.y) / m_height,
+    float(region.x + region.width) / m_width,
+    float(region.y + region.height) / m_height
+  );
+}
+
+void TextureAtlas::compact()
+{
+  // Largest images first pack tighter.
+  std::vector<Handle> handles;
+  for (const auto &entry : m_regions)
+  {
+    handles.push_back(entry.first);
+  }
+
+  std::sort(handles.begin(), handles.end(), [this](Handle a, Handle b) {
+    const Region &first = m_regions[a];
+    const Region &second = m_regions[b];
+    return (first.height != second.height) ? first.height > second.height : first.width > second.width;
+  });
+
+  for (SkylinePacker &packer : m_packers)
+  {
+    packer.reset();
+  }
+
+  std::unordered_map<Handle, Region> regions;
+  for (Handle handle : handles)
+  {
+    const Region &region = m_regions[handle];
+    Region packed;
+
+    while (!pack(region.width, region.height, packed))
+    {
+      m_packers.push_back(SkylinePacker(m_width, m_height));
+    }
+
+    regions.emplace(handle, packed);
+  }
+
+  // Moves may overlap, copy into a new texture.
+  Texture *texture = createTexture(m_packers.size());
+
+  for (Handle handle : handles)
+  {
+    const Region &source = m_regions[handle];
+    const Region &destination = regions[handle];
+
+    glCopyImageSubData(
+      m_texture->getId(), GL_TEXTURE_2D_ARRAY, 0,
+      source.x, source.y, source.layer,
+      texture->getId(), GL_TEXTURE_2D_ARRAY, 0,
+      destination.x, destination.y, destination.layer,
+      source.width + m_padding, source.height + m_padding, 1
+    );
+  }
+
+  delete m_texture;
+
+  m_texture = texture;
+  m_regions.swap(regions);
+}
+
+bool TextureAtlas::pack(size_t width, size_t height, Region &region)
+{
+  for (size_t layer = 0; layer < m_packers.size(); ++layer)
+  {
+    size_t x, y;
+
+    if (m_packers[layer].pack(width + m_padding, height + m_padding, x, y))
+    {
+      region = Region{layer, x, y, width, height};
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Texture* TextureAtlas::createTexture(size_t layers) const
+{
+  Texture *texture = new Texture();
+
+  texture->bind(GL_TEXTURE_2D_ARRAY);
+  texture->allocateStorage(1, m_internalFormat, m_width, m_height, layers);
+
+  if (m_texture)
+    texture->copyParameters(*m_texture);
+
+  texture->unbind();
+
+  return texture;
+}
+
+void TextureAtlas::grow(size_t layers)
+{
+  assert(layers > m_packers.size());
+
+  Texture *texture = createTexture(layers);
+
+  glCopyImageSubData(
+    m_texture->getId(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+    texture->getId(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+    m_width, m_height, m_packers.size()
+  );
+
+  delete m_texture;
+
+  m_texture = texture;
+  m_packers.resize(layers, SkylinePacker(m_width, m_height));
+}
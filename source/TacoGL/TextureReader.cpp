@@ -0,0 +1,57 @@
+#include <cassert>
+
+#include <TacoGL/TextureReader.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+TextureReader::TextureReader(size_t capacity, size_t count)
+: m_readbacks(), m_next(0)
+{
+  assert(count > 0);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    m_readbacks.push_back(new Readback(capacity));
+  }
+}
+
+TextureReader::~TextureReader()
+{
+  for (Readback *readback : m_readbacks)
+  {
+    delete readback;
+  }
+}
+
+Readback& TextureReader::read(
+  const Texture &texture,
+  size_t level,
+  size_t x, size_t y,
+  size_t width, size_t height,
+  GLenum format,
+  GLenum type
+)
+{
+  return read(texture, level, x, y, 0, width, height, 1, format, type);
+}
+
+Readback& TextureReader::read(
+  const Texture &texture,
+  size_t level,
+  size_t x, size_t y, size_t z,
+  size_t width, size_t height, size_t depth,
+  GLenum format,
+  GLenum type
+)
+{
+  Readback &readback = *m_readbacks[m_next];
+  m_next = (m_next + 1) % m_readbacks.size();
+
+  // The GPU may still write the previous read.
+  readback.wait();
+
+  texture.readAsync(readback, level, x, y, z, width, height, depth, format, type);
+
+  return readback;
+}
@@ -0,0 +1,182 @@
+#include <cassert>
+
+#include <TacoGL/TextureUploader.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+//======//
+// Slot //
+//======//
+
+TextureUploader::Slot::Slot(size_t index, size_t size)
+: m_buffer(), m_fence(), m_data(nullptr), m_index(index), m_acquired(false)
+{
+  bool binding = !Buffer::isDirectStateAccessEnabled();
+
+  if (binding)
+    m_buffer.bind(GL_PIXEL_UNPACK_BUFFER);
+
+  m_buffer.allocate<unsigned char>(
+    size,
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT
+  );
+
+  m_data = m_buffer.mapData(
+    0,
+    size,
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT
+  );
+
+  if (binding)
+    m_buffer.unbind();
+}
+
+TextureUploader::Slot::~Slot()
+{
+  bool binding = !Buffer::isDirectStateAccessEnabled();
+
+  if (binding)
+    m_buffer.bind(GL_PIXEL_UNPACK_BUFFER);
+
+  m_buffer.unmap();
+
+  if (binding)
+    m_buffer.unbind();
+}
+
+//==================//
+// Texture Uploader //
+//==================//
+
+TextureUploader::TextureUploader(size_t slotSize, size_t slotCount)
+: m_slots(), m_slotSize(slotSize), m_next(0)
+{
+  assert(slotCount > 0);
+
+  for (size_t i = 0; i < slotCount; ++i)
+  {
+    m_slots.push_back(new Slot(i, slotSize));
+  }
+}
+
+TextureUploader::~TextureUploader()
+{
+  for (Slot *slot : m_slots)
+  {
+    delete slot;
+  }
+}
+
+TextureUploader::Slot* TextureUploader::tryAcquire()
+{
+  for (size_t i = 0; i < m_slots.size(); ++i)
+  {
+    Slot &slot = *m_slots[(m_next + i) % m_slots.size()];
+
+    if (!slot.m_acquired && slot.m_fence.isSignaled())
+      return &take(slot);
+  }
+
+  return nullptr;
+}
+
+TextureUploader::Slot& TextureUploader::acquire()
+{
+  Slot *available = tryAcquire();
+
+  if (available)
+    return *available;
+
+  // Wait for the oldest submitted slot.
+  for (size_t i = 0; i < m_slots.size(); ++i)
+  {
+    Slot &slot = *m_slots[(m_next + i) % m_slots.size()];
+
+    if (!slot.m_acquired)
+    {
+      slot.m_fence.wait();
+      return take(slot);
+    }
+  }
+
+  assert(false && "all slots are acquired");
+  return *m_slots[m_next];
+}
+
+TextureUploader::Slot& TextureUploader::take(Slot &slot)
+{
+  slot.m_fence.reset();
+  slot.m_acquired = true;
+  m_next = (slot.m_index + 1) % m_slots.size();
+
+  return slot;
+}
+
+void TextureUploader::upload(
+  Slot &slot,
+  size_t offset,
+  Texture &texture,
+  size_t level,
+  size_t x, size_t y,
+  size_t width, size_t height,
+  GLenum format,
+  GLenum type
+)
+{
+  assert(slot.m_acquired);
+  assert(offset < slot.size());
+
+  // With a PIXEL_UNPACK buffer binded, the data pointer is an offset.
+  slot.m_buffer.bind(GL_PIXEL_UNPACK_BUFFER);
+  texture.setSubData(
+    level,
+    x, y,
+    width, height,
+    format,
+    type,
+    reinterpret_cast<const void*>(offset)
+  );
+  slot.m_buffer.unbind();
+}
+
+void TextureUploader::upload(
+  Slot &slot,
+  size_t offset,
+  Texture &texture,
+  size_t level,
+  size_t x, size_t y, size_t z,
+  size_t width, size_t height, size_t depth,
+  GLenum format,
+  GLenum type
+)
+{
+  assert(slot.m_acquired);
+  assert(offset < slot.size());
+
+  slot.m_buffer.bind(GL_PIXEL_UNPACK_BUFFER);
+  texture.setSubData(
+    level,
+    x, y, z,
+    width, height, depth,
+    format,
+    type,
+    reinterpret_cast<const void*>(offset)
+  );
+  slot.m_buffer.unbind();
+}
+
+void TextureUploader::submit(Slot &slot)
+{
+  assert(slot.m_acquired);
+
+  slot.m_fence.set();
+  slot.m_acquired = false;
+}
+
+void TextureUploader::cancel(Slot &slot)
+{
+  assert(slot.m_acquired);
+
+  slot.m_acquired = false;
+}
@@ -1,3 +1,4 @@
+#include <TacoGL/Buffer.h>
 #include <TacoGL/VertexArray.h>
 
 using namespace TacoGL;
@@ -15,9 +16,14 @@ VertexArray::~VertexArray()
 void VertexArray::bind()
 {
     gl::glBindVertexArray(m_id);
+
+    // The element array binding is part of the vertex array state.
+    Buffer::resetBinding(gl::GL_ELEMENT_ARRAY_BUFFER);
 }
 
 void VertexArray::unbind()
 {
     gl::glBindVertexArray(0);
+
+    Buffer::resetBinding(gl::GL_ELEMENT_ARRAY_BUFFER);
 }
@@ -0,0 +1,309 @@
+#include <TacoGL/format.h>
+
+using namespace gl;
+using namespace TacoGL;
+
+GLenum TacoGL::getSizedFormat(GLenum internalFormat)
+{
+  switch (internalFormat)
+  {
+    case GL_RED:
+    case GL_COMPRESSED_RED:
+      return GL_R8;
+
+    case GL_RG:
+    case GL_COMPRESSED_RG:
+      return GL_RG8;
+
+    case GL_RGB:
+    case GL_COMPRESSED_RGB:
+      return GL_RGB8;
+
+    case GL_RGBA:
+    case GL_COMPRESSED_RGBA:
+      return GL_RGBA8;
+
+    case GL_SRGB:
+    case GL_COMPRESSED_SRGB:
+      return GL_SRGB8;
+
+    case GL_SRGB_ALPHA:
+    case GL_COMPRESSED_SRGB_ALPHA:
+      return GL_SRGB8_ALPHA8;
+
+    case GL_DEPTH_COMPONENT:
+      return GL_DEPTH_COMPONENT24;
+
+    case GL_DEPTH_STENCIL:
+      return GL_DEPTH24_STENCIL8;
+
+    case GL_STENCIL_INDEX:
+      return GL_STENCIL_INDEX8;
+
+    default:
+      return internalFormat;
+  }
+}
+
+size_t TacoGL::getFormatBits(GLenum internalFormat)
+{
+  switch (getSizedFormat(internalFormat))
+  {
+    case GL_R8:
+    case GL_R8_SNORM:
+    case GL_R8I:
+    case GL_R8UI:
+    case GL_R3_G3_B2:
+    case GL_RGBA2:
+    case GL_STENCIL_INDEX8:
+      return 8;
+
+    case GL_R16:
+    case GL_R16_SNORM:
+    case GL_R16F:
+    case GL_R16I:
+    case GL_R16UI:
+    case GL_RG8:
+    case GL_RG8_SNORM:
+    case GL_RG8I:
+    case GL_RG8UI:
+    case GL_RGB4:
+    case GL_RGB5:
+    case GL_RGB565:
+    case GL_RGBA4:
+    case GL_RGB5_A1:
+    case GL_DEPTH_COMPONENT16:
+      return 16;
+
+    case GL_RGB8:
+    case GL_RGB8_SNORM:
+    case GL_RGB8I:
+    case GL_RGB8UI:
+    case GL_SRGB8:
+    case GL_DEPTH_COMPONENT24:
+      return 24;
+
+    case GL_R32F:
+    case GL_R32I:
+    case GL_R32UI:
+    case GL_RG16:
+    case GL_RG16_SNORM:
+    case GL_RG16F:
+    case GL_RG16I:
+    case GL_RG16UI:
+    case GL_RGBA8:
+    case GL_RGBA8_SNORM:
+    case GL_RGBA8I:
+    case GL_RGBA8UI:
+    case GL_SRGB8_ALPHA8:
+    case GL_RGB10_A2:
+    case GL_RGB10_A2UI:
+    case GL_R11F_G11F_B10F:
+    case GL_RGB9_E5:
+    case GL_DEPTH_COMPONENT32:
+    case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8:
+      return 32;
+
+    case GL_RGB16:
+    case GL_RGB16_SNORM:
+    case GL_RGB16F:
+    case GL_RGB16I:
+    case GL_RGB16UI:
+      return 48;
+
+    case GL_RG32F:
+    case GL_RG32I:
+    case GL_RG32UI:
+    case GL_RGBA16:
+    case GL_RGBA16_SNORM:
+    case GL_RGBA16F:
+    case GL_RGBA16I:
+    case GL_RGBA16UI:
+    case GL_DEPTH32F_STENCIL8:
+      return 64;
+
+    case GL_RGB32F:
+    case GL_RGB32I:
+    case GL_RGB32UI:
+      return 96;
+
+    case GL_RGBA32F:
+    case GL_RGBA32I:
+    case GL_RGBA32UI:
+      return 128;
+
+    // 8 bytes per 4x4 block
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_SIGNED_RED_RGTC1:
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_SRGB8_ETC2:
+    case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_R11_EAC:
+    case GL_COMPRESSED_SIGNED_R11_EAC:
+      return 4;
+
+    // 16 bytes per 4x4 block
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_SIGNED_RG_RGTC2:
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+    case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+    case GL_COMPRESSED_RG11_EAC:
+    case GL_COMPRESSED_SIGNED_RG11_EAC:
+      return 8;
+
+    default:
+      return 0;
+  }
+}
+
+bool TacoGL::isCompressedFormat(GLenum internalFormat)
+{
+  switch (internalFormat)
+  {
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_SIGNED_RED_RGTC1:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_SIGNED_RG_RGTC2:
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_SRGB8_ETC2:
+    case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+    case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+    case GL_COMPRESSED_R11_EAC:
+    case GL_COMPRESSED_SIGNED_R11_EAC:
+    case GL_COMPRESSED_RG11_EAC:
+    case GL_COMPRESSED_SIGNED_RG11_EAC:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+size_t TacoGL::getImageSize(GLenum internalFormat, size_t width, size_t height, size_t depth)
+{
+  size_t bits = getFormatBits(internalFormat);
+
+  if (isCompressedFormat(internalFormat))
+  {
+    // 4x4 blocks, 16 texels each.
+    size_t blocks = ((width + 3) / 4) * ((height + 3) / 4) * depth;
+    return blocks * bits * 16 / 8;
+  }
+
+  return width * height * depth * bits / 8;
+}
+
+size_t TacoGL::getPixelSize(GLenum format, GLenum type)
+{
+  size_t components = 0;
+
+  switch (format)
+  {
+    case GL_RED:
+    case GL_GREEN:
+    case GL_BLUE:
+    case GL_RED_INTEGER:
+    case GL_GREEN_INTEGER:
+    case GL_BLUE_INTEGER:
+    case GL_DEPTH_COMPONENT:
+    case GL_STENCIL_INDEX:
+      components = 1;
+      break;
+
+    case GL_RG:
+    case GL_RG_INTEGER:
+    case GL_DEPTH_STENCIL:
+      components = 2;
+      break;
+
+    case GL_RGB:
+    case GL_BGR:
+    case GL_RGB_INTEGER:
+    case GL_BGR_INTEGER:
+      components = 3;
+      break;
+
+    case GL_RGBA:
+    case GL_BGRA:
+    case GL_RGBA_INTEGER:
+    case GL_BGRA_INTEGER:
+      components = 4;
+      break;
+
+    default:
+      return 0;
+  }
+
+  switch (type)
+  {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+      return components;
+
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+      return 2 * components;
+
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+      return 4 * components;
+
+    // Packed types, a whole pixel.
+    case GL_UNSIGNED_BYTE_3_3_2:
+    case GL_UNSIGNED_BYTE_2_3_3_REV:
+      return 1;
+
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_5_6_5_REV:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+    case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+      return 2;
+
+    case GL_UNSIGNED_INT_8_8_8_8:
+    case GL_UNSIGNED_INT_8_8_8_8_REV:
+    case GL_UNSIGNED_INT_10_10_10_2:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_24_8:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+    case GL_UNSIGNED_INT_5_9_9_9_REV:
+      return 4;
+
+    case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+      return 8;
+
+    default:
+      return 0;
+  }
+}
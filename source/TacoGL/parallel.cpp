@@ -0,0 +1,151 @@
+#include <cassert>
+#include <algorithm>
+
+#include <TacoGL/parallel.h>
+
+using namespace TacoGL;
+
+namespace
+{
+  /**
+   * Set inside tasks, nested runs are processed serially.
+   */
+  thread_local bool _insideTask = false;
+}
+
+ThreadPool& ThreadPool::getGlobal()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+ThreadPool::ThreadPool(size_t threads)
+: m_workers(),
+  m_stopped(false),
+  m_generation(0),
+  m_active(0),
+  m_task(nullptr),
+  m_count(0),
+  m_grain(1),
+  m_next(0),
+  m_error()
+{
+  if (threads == 0)
+    threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+  for (size_t i = 1; i < threads; ++i)
+    m_workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+
+  m_start.notify_all();
+
+  for (std::thread &worker : m_workers)
+    worker.join();
+}
+
+void ThreadPool::run(size_t count, const Task &task, size_t grain)
+{
+  assert(grain > 0);
+
+  if (count == 0)
+    return;
+
+  if (_insideTask || m_workers.empty() || count <= grain)
+  {
+    task(0, count);
+    return;
+  }
+
+  std::lock_guard<std::mutex> runLock(m_runMutex);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_task = &task;
+    m_count = count;
+    m_grain = grain;
+    m_next = 0;
+    m_error = nullptr;
+    m_active = m_workers.size();
+    ++m_generation;
+  }
+
+  m_start.notify_all();
+  process();
+
+  std::exception_ptr error;
+
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&]() { return m_active == 0; });
+
+    m_task = nullptr;
+    error = m_error;
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void ThreadPool::work()
+{
+  size_t generation = 0;
+
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start.wait(lock, [&]() { return m_stopped || m_generation != generation; });
+
+      if (m_stopped)
+        return;
+
+      generation = m_generation;
+    }
+
+    process();
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      --m_active;
+    }
+
+    m_done.notify_one();
+  }
+}
+
+void ThreadPool::process()
+{
+  _insideTask = true;
+
+  for (;;)
+  {
+    size_t first = m_next.fetch_add(m_grain);
+
+    if (first >= m_count)
+      break;
+
+    try
+    {
+      (*m_task)(first, std::min(first + m_grain, m_count));
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (!m_error)
+        m_error = std::current_exception();
+
+      // Skip the remaining ranges.
+      m_next = m_count;
+    }
+  }
+
+  _insideTask = false;
+}